@@ -16,6 +16,11 @@ std::string Expression::MakeIR_lvalue(VariableMap const& bindings, FunctionStack
 	throw compile_error((std::string)"l-value assembly generation not implemented for " + typeid(*this).name());
 }
 
+void Expression::MakeIR_branch(VariableMap const& bindings, FunctionStack& stack, IRVector& out, std::string label, bool jump_if) const {
+	std::string res = MakeIR(bindings, stack, out);
+	out.push_back(new GotoIfInstruction(label, res, "", jump_if ? '!' : '='));
+}
+
 int32_t Expression::evaluate_int(VariableMap const& bindings) const {
 	throw compile_error((std::string)"cannot evalute " + typeid(*this).name() + " as a constant integer", sourceFile, sourceLine);
 }
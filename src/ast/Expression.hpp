@@ -26,6 +26,8 @@ public:
 
 	virtual std::string MakeIR(VariableMap const& bindings, FunctionStack& stack, IRVector& out) const = 0;
 	virtual std::string MakeIR_lvalue(VariableMap const& bindings, FunctionStack& stack, IRVector& out) const = 0;
+	// jump to label if the expression is true (jump_if) or false (!jump_if), fall through otherwise
+	virtual void MakeIR_branch(VariableMap const& bindings, FunctionStack& stack, IRVector& out, std::string label, bool jump_if) const;
 
 	virtual int32_t evaluate_int(VariableMap const& bindings) const;
 };
@@ -1,13 +1,38 @@
 #include "Function.hpp"
 
+#include "../intrep/ControlFlowGraph.hpp"
+#include "../intrep/Inliner.hpp"
+#include "../intrep/Liveness.hpp"
+#include "../intrep/MachineCode.hpp"
+#include "../intrep/PassManager.hpp"
+#include "../intrep/RegisterAllocator.hpp"
+#include "../intrep/StackSlots.hpp"
+#include "../intrep/TailCalls.hpp"
+
+#include <algorithm>
 #include <sstream>
 
-Function::Function() : Scope(), prototype_only(false), has_ellipsis(false) {}
+Function::Function() : Scope(), prototype_only(false), has_ellipsis(false), inline_hint(false) {}
 
 void Function::merge_parameters(Scope *scope) {
 	parameters.insert(parameters.end(), scope->declarations.begin(), scope->declarations.end());
 }
 
+void Function::set_return_type(std::vector<std::string> specifiers, int pointer_depth) {
+	std::vector<std::string>::iterator hint;
+	while((hint = std::find(specifiers.begin(), specifiers.end(), "inline")) != specifiers.end()) {
+		specifiers.erase(hint);
+		inline_hint = true;
+	}
+	return_type = Type(specifiers, pointer_depth);
+}
+
+DefinitionMap _function_definitions;
+
+DefinitionMap& function_definitions() {
+	return _function_definitions;
+}
+
 void Function::Debug(std::ostream& dst, int indent) const {
 	dst << std::endl << spaces(indent) << "Function (" << function_name << ") type:";
 	dst << return_type.name();
@@ -53,20 +78,93 @@ void Function::PrintXML(std::ostream& dst, int indent) const {
 	dst << spaces(indent) << "</Function>" << std::endl;
 }
 
-void Function::make_instructions(VariableMap& bindings, FunctionStack& stack, IRVector& out) const {
+void Function::lower(VariableMap& bindings, FunctionStack& stack, IRVector& out) const {
 	// populate the bindings with the function parameters and declarations
 	bindings.add_bindings(parameters);
 	bindings.add_bindings(declarations);
+	stack.add_variables(bindings, parameters);
 	stack.add_variables(bindings, declarations);
 
-	// generate instructions for initialisers
-	for(std::vector<Declaration*>::const_iterator itr = declarations.begin(); itr != declarations.end(); ++itr) {
-		(*itr)->MakeIR_initialisers(bindings, stack, out);
+	{
+		PassTimer timer("lower-ir");
+
+		// generate instructions for initialisers
+		for(std::vector<Declaration*>::const_iterator itr = declarations.begin(); itr != declarations.end(); ++itr) {
+			(*itr)->MakeIR_initialisers(bindings, stack, out);
+		}
+
+		// generate instructions from statements
+		for(std::vector<Statement*>::const_iterator itr = statements.begin(); itr != statements.end(); ++itr) {
+			(*itr)->MakeIR(bindings, stack, out);
+		}
 	}
+}
 
-	// generate instructions from statements
-	for(std::vector<Statement*>::const_iterator itr = statements.begin(); itr != statements.end(); ++itr) {
-		(*itr)->MakeIR(bindings, stack, out);
+void Function::make_instructions(VariableMap& bindings, FunctionStack& stack, IRVector& out) const {
+	VariableMap globals = bindings;
+	lower(bindings, stack, out);
+
+	// copy small callees in first, so the IR passes see through them
+	if(pass_manager().enabled("inline")) {
+		PassTimer timer("inline");
+		inline_calls(globals, stack, out);
+		pass_manager().print_after("inline", function_name, out);
+	}
+
+	// calls to itself just before returning become a loop
+	if(pass_manager().enabled("tail-calls") && !has_ellipsis && !return_type.is_struct()) {
+		PassTimer timer("tail-calls");
+		std::vector<std::string> parameter_aliases;
+		for(std::vector<Declaration*>::const_iterator itr = parameters.begin(); itr != parameters.end(); ++itr) {
+			parameter_aliases.push_back(bindings.at((*itr)->identifier).alias);
+		}
+		loop_tail_recursion(out, stack, function_name, parameter_aliases);
+		pass_manager().print_after("tail-calls", function_name, out);
+	}
+
+	// run the IR passes of the current optimisation level
+
+	pass_manager().run(function_name, out, stack);
+}
+
+/*
+ * Replace calls to functions defined in this program with a copy of their body when
+ * the callee is tiny, or when it is declared inline or called from a single place and
+ * not too large.  Each copy is lowered afresh, so unique() gives all of its variables,
+ * temporaries and labels new names.  Only the calls already in the function are
+ * considered: calls inside a copied body stay calls.
+ */
+void Function::inline_calls(VariableMap const& globals, FunctionStack& stack, IRVector& out) const {
+	DefinitionMap const& definitions = function_definitions();
+	unsigned threshold = pass_options().inline_threshold;
+	unsigned i = 0;
+	while(i < out.size()) {
+		FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(out.at(i));
+		DefinitionMap::const_iterator callee = call ? definitions.find(call->get_function_name()) : definitions.end();
+		if(callee == definitions.end() || callee->first == function_name || !callee->second.inlinable) {
+			i++;
+			continue;
+		}
+		FunctionDefinition const& definition = callee->second;
+		bool wanted = definition.cost <= threshold
+			|| ((definition.function->inline_hint || definition.call_sites == 1) && definition.cost <= 8 * threshold);
+		if(!wanted || definition.function->has_ellipsis
+			|| definition.function->parameters.size() != call->get_arguments().size()) {
+			i++;
+			continue;
+		}
+
+		VariableMap callee_bindings = globals;
+		FunctionStack callee_stack;
+		IRVector body;
+		definition.function->lower(callee_bindings, callee_stack, body);
+		std::vector<std::string> parameters;
+		for(std::vector<Declaration*>::const_iterator p = definition.function->parameters.begin(); p != definition.function->parameters.end(); ++p) {
+			parameters.push_back(callee_bindings.at((*p)->identifier).alias);
+		}
+		stack.insert(callee_stack.begin(), callee_stack.end());
+		stack.arrays.insert(callee_stack.arrays.begin(), callee_stack.arrays.end());
+		i = splice_call(out, i, body, parameters, stack);
 	}
 }
 
@@ -96,11 +194,25 @@ void Function::CompileIR(VariableMap bindings, std::ostream &dst) const {
 	dst << std::endl;
 }
 
+void Function::CompileCFG(VariableMap bindings, std::ostream &dst) const {
+	FunctionStack stack;
+	IRVector out;
+	make_instructions(bindings, stack, out);
+	ControlFlowGraph cfg(out);
+
+	dst << function_name << ":" << std::endl;
+	cfg.Debug(dst);
+	dst << "    # end " << function_name << std::endl;
+	dst << std::endl;
+}
+
 void debug_stack_allocations(std::map<std::string, unsigned> const& array_addresses,
 							std::map<std::string, unsigned> const& stack_offsets,
 							unsigned stack_size,
-							unsigned param_stack)
+							unsigned param_stack,
+							unsigned unshared_size)
 							{
+	std::cerr << "# frame size: " << stack_size << " bytes (" << unshared_size << " without slot sharing)\n";
 	for(unsigned addr = 0; addr < param_stack; addr++) {
 		if(addr == stack_size) {
 			std::cerr << "#  -----\n";
@@ -113,7 +225,7 @@ void debug_stack_allocations(std::map<std::string, unsigned> const& array_addres
 		}
 		for(std::map<std::string, unsigned>::const_iterator itr = stack_offsets.begin(); itr != stack_offsets.end(); ++itr) {
 			if(itr->second == addr) {
-				std::cerr << itr->first;
+				std::cerr << itr->first << " ";
 			}
 		}
 		if(addr == stack_size - 4) {
@@ -126,12 +238,103 @@ void debug_stack_allocations(std::map<std::string, unsigned> const& array_addres
 	}
 }
 
+void debug_register_allocation(std::map<std::string, unsigned> const& registers) {
+	for(std::map<std::string, unsigned>::const_iterator itr = registers.begin(); itr != registers.end(); ++itr) {
+		std::cerr << "# " << itr->first << ": $" << itr->second << "\n";
+	}
+	std::cerr << "\n";
+}
+
 void Function::CompileMIPS(VariableMap globals, std::ostream &dst, std::ostream &buff) const {
 	VariableMap bindings = globals;
 	FunctionStack stack;
 	IRVector out;
 	make_instructions(bindings, stack, out);
 
+	// a leaf function calls nothing: $31 survives and $4-$7 are free after the prologue
+	bool trim_frame = pass_manager().enabled("frame-elision");
+	bool leaf = trim_frame;
+	std::set<std::string> referenced = address_taken_variables(out);
+	for(IRVector::const_iterator itr = out.begin(); itr != out.end(); ++itr) {
+		if(dynamic_cast<FunctionCallInstruction*>(*itr)) leaf = false;
+		std::vector<std::string> sources = (*itr)->get_sources();
+		referenced.insert(sources.begin(), sources.end());
+		referenced.insert((*itr)->get_destination());
+	}
+
+	// where each parameter sits in the argument area, relative to the caller's $sp
+	// if we return a struct, space will have been allocated for us, and its address will be in $4
+	std::vector<std::string> parameter_aliases;
+	std::map<std::string, unsigned> argument_offsets;
+	std::map<std::string, unsigned> argument_registers;
+	// register each word-sized parameter arrives in, when it is passed in one
+	std::map<std::string, std::string> incoming_registers;
+	unsigned argument_offset = return_type.is_struct() ? 4 : 0;
+	for(std::vector<Declaration*>::const_iterator itr = parameters.begin(); itr != parameters.end(); ++itr) {
+		std::string param_alias = bindings.at((*itr)->identifier).alias;
+		Type param_type = (*itr)->var_type;
+		parameter_aliases.push_back(param_alias);
+		align_address(argument_offset, param_type.is_float() ? param_type.bytes() : 4, 8);
+		if(param_type.bytes() == 1) argument_offset += 3;
+		if(param_type.bytes() == 2) argument_offset += 2;
+		argument_offsets[param_alias] = argument_offset;
+		if(!has_ellipsis && param_type.bytes() == 4 && !param_type.is_float() && argument_offset < 16) {
+			std::stringstream reg;
+			reg << "$" << FIRST_ARGUMENT_REGISTER + argument_offset / 4;
+			incoming_registers[param_alias] = reg.str();
+			// a word-sized integer or pointer can stay in the register it arrives in
+			if(leaf) argument_registers[param_alias] = FIRST_ARGUMENT_REGISTER + argument_offset / 4;
+		}
+		// the first two floating point parameters also come in $f12 and $f14
+		unsigned index = itr - parameters.begin();
+		bool float_argument = index == 0 || (index == 1 && parameters.at(0)->var_type.is_float());
+		if(!has_ellipsis && !return_type.is_struct() && param_type.is_float() && param_type.bytes() == 4 && float_argument) {
+			incoming_registers[param_alias] = index == 0 ? "$f12" : "$f14";
+		}
+		argument_offset += param_type.bytes();
+	}
+
+	// calls just before a return can leave through the callee when its arguments fit in
+	// registers and in the area our own caller set aside for ours, and its result needs
+	// no conversion into ours
+	if(pass_manager().enabled("tail-calls") && !has_ellipsis && !return_type.is_struct() && frame_reusable(out, stack)) {
+		PassTimer timer("tail-calls");
+		unsigned incoming_area = argument_offset + 8;
+		align_address(incoming_area, 8, 8);
+		bool returns_void = return_type.builtin_type == Type::Void && !return_type.is_pointer();
+		std::vector<unsigned> calls = tail_calls(out);
+		for(std::vector<unsigned>::const_iterator itr = calls.begin(); itr != calls.end(); ++itr) {
+			FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(out.at(*itr));
+			VariableMap::const_iterator callee = globals.find(call->get_function_name());
+			if(callee == globals.end() || !callee->second.is_function || callee->second.type.is_struct()) continue;
+			if(!returns_void && !callee->second.type.equals(return_type)) continue;
+			std::vector<Type> const& params = callee->second.params;
+			bool fits = params.size() == call->get_arguments().size();
+			unsigned end = 0;
+			for(std::vector<Type>::const_iterator p = params.begin(); fits && p != params.end(); ++p) {
+				if(p->is_struct()) fits = false;
+				align_address(end, p->is_float() ? p->bytes() : 4, 8);
+				end += p->bytes() < 4 ? 4 : p->bytes();
+			}
+			if(fits && end <= 16 && end <= incoming_area) call->set_tail();
+		}
+		pass_manager().print_after("tail-calls", function_name, out);
+	}
+
+	// parameters live in the caller's frame, everything else may get a register
+	ControlFlowGraph cfg(out);
+	Liveness liveness(cfg, stack);
+	std::set<std::string> address_taken = address_taken_variables(out);
+	std::map<std::string, unsigned> registers;
+	if(pass_manager().enabled("regalloc")) {
+		PassTimer timer("regalloc");
+		registers = allocate_registers(liveness, stack, globals, address_taken, leaf, argument_registers);
+		pass_manager().print_after("regalloc", function_name, out);
+		if(pass_options().print_after == "regalloc") {
+			debug_register_allocation(registers);
+		}
+	}
+
 	// figure out where things are going to be on the stack
 	std::map<std::string, unsigned> array_addresses;
 	std::map<std::string, unsigned> stack_offsets;
@@ -141,91 +344,192 @@ void Function::CompileMIPS(VariableMap globals, std::ostream &dst, std::ostream
 		array_addresses[(*itr).first] = stack_size;
 		stack_size += (*itr).second.total_size();
 	}
+	std::vector<std::string> frame_variables;
+	unsigned unshared_size = stack_size;
 	for(FunctionStack::const_iterator itr = stack.begin(); itr != stack.end(); ++itr) {
-		align_address(stack_size, (*itr).second.bytes());
-		stack_offsets[(*itr).first] = stack_size;
-		stack_size += (*itr).second.bytes();
+		if(registers.count((*itr).first)) continue;
+		if(std::find(parameter_aliases.begin(), parameter_aliases.end(), (*itr).first) != parameter_aliases.end()) continue;
+		frame_variables.push_back((*itr).first);
+		align_address(unshared_size, (*itr).second.bytes());
+		unshared_size += (*itr).second.bytes();
+	}
+	stack_size = allocate_stack_slots(frame_variables, stack, liveness, address_taken, stack_size, stack_offsets);
+
+	// callee-saved registers used by this function
+	std::map<unsigned, unsigned> saved_registers;
+	for(std::map<std::string, unsigned>::const_iterator itr = registers.begin(); itr != registers.end(); ++itr) {
+		if(itr->second >= FIRST_SAVED_REGISTER && itr->second <= LAST_SAVED_REGISTER) {
+			saved_registers[itr->second] = 0;
+		}
+	}
+	align_address(stack_size, 4);
+	for(std::map<unsigned, unsigned>::iterator itr = saved_registers.begin(); itr != saved_registers.end(); ++itr) {
+		itr->second = stack_size;
+		stack_size += 4;
 	}
-	stack_size += 8;
+	// frame pointer, and the return address unless this is a leaf
+	stack_size += leaf ? 4 : 8;
+	align_address(unshared_size, 4);
+	unshared_size += 4 * saved_registers.size() + 8;
 
 	// stack must be 8-byte aligned
 	align_address(stack_size, 8, 8);
+	align_address(unshared_size, 8, 8);
 
-	// assign locations in the stack to function parameters
-	unsigned parameters_stack = stack_size;
+	// assign addresses to incoming parameters
+	for(std::map<std::string, unsigned>::const_iterator itr = argument_offsets.begin(); itr != argument_offsets.end(); ++itr) {
+		stack_offsets[itr->first] = stack_size + itr->second;
+	}
 
-	// if we return a struct, space will have been allocated for us, and its address will be in $4
+	// argument words the body reads from the stack: parameters that are used and not kept
+	// in their own argument register, the struct return address, everything for varargs
+	std::vector<bool> spill_argument(4, has_ellipsis || !trim_frame);
 	if(return_type.is_struct()) {
-		parameters_stack += 4;
+		spill_argument.at(0) = true;
 	}
-
-	// assign addresses to incoming parameters
+	bool parameters_in_memory = has_ellipsis || return_type.is_struct();
 	for(std::vector<Declaration*>::const_iterator itr = parameters.begin(); itr != parameters.end(); ++itr) {
 		std::string param_alias = bindings.at((*itr)->identifier).alias;
-		align_address(parameters_stack, (*itr)->var_type.is_float() ? (*itr)->var_type.bytes() : 4, 8);
-		if((*itr)->var_type.bytes() == 1) parameters_stack += 3;
-		if((*itr)->var_type.bytes() == 2) parameters_stack += 2;
-		stack_offsets[param_alias] = parameters_stack;
-		parameters_stack += (*itr)->var_type.bytes();
+		if(trim_frame && !referenced.count(param_alias)) continue;
+		if(argument_registers.count(param_alias) && registers.count(param_alias)
+			&& registers.at(param_alias) == argument_registers.at(param_alias)) continue;
+		if(incoming_registers.count(param_alias) && registers.count(param_alias)
+			&& (registers.at(param_alias) < FIRST_ARGUMENT_REGISTER || registers.at(param_alias) > LAST_ARGUMENT_REGISTER)) continue;
+		parameters_in_memory = true;
+		unsigned first = argument_offsets.at(param_alias);
+		for(unsigned word = first / 4; word < 4 && word * 4 < first + (*itr)->var_type.bytes(); word++) {
+			spill_argument.at(word) = true;
+		}
 	}
 
 	// create a context for the IR language to run in
-	stack.add_variables(bindings, parameters);
-	IRContext context(globals, stack, stack_offsets, function_name, return_type, stack_size);
-	/* */
-	//debug_stack_allocations(array_addresses, stack_offsets, stack_size, parameters_stack);
+	IRContext context(globals, stack, stack_offsets, registers, function_name, return_type, stack_size);
+
+	// tearing the frame down, also needed by tail calls in the body
+	std::stringstream epilogue;
+	epilogue << "    move    $sp, $fp\n"; // get back the base stack pointer
+	for(std::map<unsigned, unsigned>::const_iterator itr = saved_registers.begin(); itr != saved_registers.end(); ++itr) {
+		epilogue << "    lw      $" << itr->first << ", " << itr->second << "($sp)\n"; // restore callee-saved registers
+	}
+	if(!leaf) {
+		epilogue << "    lw      $31, " << (stack_size - 8) << "($sp)" << "\n"; // load return address
+	}
+	epilogue << "    lw      $fp, " << (stack_size - 4) << "($sp)" << "\n"; // load previous frame pointer
+	epilogue << "    addiu   $sp, $sp, " << stack_size << "\n"; // release allocated stack
+	context.set_epilogue(epilogue.str());
+	if(pass_options().debug) {
+		std::cerr << "# frame of " << function_name << "\n";
+		debug_stack_allocations(array_addresses, stack_offsets, stack_size, stack_size + argument_offset, unshared_size);
+	}
+
+	// function body first: whether it touches the frame decides what the prologue needs
+	std::stringstream body;
+	body << "  fnc_" << function_name << "_code:\n";
+	for(IRVector::const_iterator itr = out.begin(); itr != out.end(); ++itr) {
+		(*itr)->PrintMIPS(body, context, buff);
+	}
+	body << "  fnc_" << function_name << "_return:\n";
+
+	bool frameless = leaf && !parameters_in_memory && array_addresses.empty() && saved_registers.empty()
+		&& body.str().find("$fp") == std::string::npos;
 
 	// print MIPS assembly code
-	dst << "    .globl " << function_name << "\n    .align 4\n";
-	dst << function_name << ":\n";
+	std::stringstream code;
+	code << "    .globl " << function_name << "\n    .align 4\n";
+	code << function_name << ":\n";
+
+	if(frameless) {
+		// nothing lives in memory: no frame at all
+		code << body.str();
+		code << "    j       $31\n"; // jump to return address
+		code << "    nop\n"; // delay slot
+		code << "\n";
+
+		MachineCode machine_code = parse_assembly(code.str());
+		if(trim_frame) pass_manager().print_after("frame-elision", function_name, machine_code);
+		pass_manager().run(function_name, machine_code);
+		print_assembly(dst, machine_code);
+		return;
+	}
+
+	// one outgoing argument area below the frame pointer, large enough for every call
+	unsigned outgoing = 0;
+	for(IRVector::const_iterator itr = out.begin(); itr != out.end(); ++itr) {
+		if(FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(*itr)) {
+			outgoing = std::max(outgoing, call->argument_area(context));
+		}
+	}
 
 	// function header
-	dst << "    addiu   $sp, $sp, -" << stack_size << "\n"; // allocate stack
-	dst << "    sw      $fp, " << (stack_size - 4) << "($sp)" << "\n"; // store previous frame pointer on stack
-	dst << "    sw      $31, " << (stack_size - 8) << "($sp)" << "\n"; // store return address on stack
-	dst << "    move    $fp, $sp\n"; // create new frame pointer
+	code << "    addiu   $sp, $sp, -" << (stack_size + outgoing) << "\n"; // allocate stack
+	code << "    sw      $fp, " << (stack_size + outgoing - 4) << "($sp)" << "\n"; // store previous frame pointer on stack
+	if(!leaf) {
+		code << "    sw      $31, " << (stack_size + outgoing - 8) << "($sp)" << "\n"; // store return address on stack
+	}
+	if(outgoing) {
+		code << "    addiu   $fp, $sp, " << outgoing << "\n"; // create new frame pointer above the arguments
+	} else {
+		code << "    move    $fp, $sp\n"; // create new frame pointer
+	}
+	for(std::map<unsigned, unsigned>::const_iterator itr = saved_registers.begin(); itr != saved_registers.end(); ++itr) {
+		code << "    sw      $" << itr->first << ", " << itr->second << "($fp)\n"; // preserve callee-saved registers
+	}
 
 	// bring parameters onto the stack
-	dst << "    sw      $4, " << stack_size << "($fp)\n";
-	dst << "    sw      $5, " << (stack_size+4) << "($fp)\n";
-	dst << "    sw      $6, " << (stack_size+8) << "($fp)\n";
-	dst << "    sw      $7, " << (stack_size+12) << "($fp)\n";
+	for(unsigned word = 0; word < 4; word++) {
+		if(spill_argument.at(word)) {
+			code << "    sw      $" << (FIRST_ARGUMENT_REGISTER + word) << ", " << (stack_size + 4 * word) << "($fp)\n";
+		}
+	}
 
 	// being floating point parameters onto the stack
-	if(parameters.size() > 0 && parameters.at(0)->var_type.is_float()) {
+	if(parameters.size() > 0 && parameters.at(0)->var_type.is_float() && spill_argument.at(0)) {
 		if(parameters.at(0)->var_type.bytes() == 4) {
-			dst << "    swc1    $f12, " << stack_size << "($fp)\n";
+			code << "    swc1    $f12, " << stack_size << "($fp)\n";
 		} else {
-			dst << "    sdc1    $f12, " << stack_size << "($fp)\n";
+			code << "    sdc1    $f12, " << stack_size << "($fp)\n";
 		}
 		if(parameters.size() > 1 && parameters.at(1)->var_type.is_float()) {
 			if(parameters.at(0)->var_type.bytes() == 4) {
-				dst << "    swc1    $f14, " << (stack_size + parameters.at(0)->var_type.bytes()) << "($fp)\n";
+				code << "    swc1    $f14, " << (stack_size + parameters.at(0)->var_type.bytes()) << "($fp)\n";
 			} else {
-				dst << "    sdc1    $f14, " << (stack_size + parameters.at(0)->var_type.bytes()) << "($fp)\n";
+				code << "    sdc1    $f14, " << (stack_size + parameters.at(0)->var_type.bytes()) << "($fp)\n";
 			}
 		}
 	}
 
+	// load parameters that live in registers, straight from the registers they came in where possible
+	for(std::vector<std::string>::const_iterator itr = parameter_aliases.begin(); itr != parameter_aliases.end(); ++itr) {
+		if(context.in_register(*itr) && liveness.live_in.at(0).count(*itr)) {
+			unsigned r = context.get_register(*itr);
+			if(argument_registers.count(*itr) && r == argument_registers.at(*itr)) continue;
+			if(incoming_registers.count(*itr) && (r < FIRST_ARGUMENT_REGISTER || r > LAST_ARGUMENT_REGISTER)) {
+				std::string from = incoming_registers.at(*itr);
+				code << (from[1] == 'f' ? "    mfc1    $" : "    move    $") << r << ", " << from << "\n";
+				continue;
+			}
+			context.load_register(code, *itr);
+		}
+	}
+
 	// assign addresses to array pointers
 	for(std::map<std::string, unsigned>::const_iterator itr = array_addresses.begin(); itr != array_addresses.end(); ++itr) {
-		dst << "    addiu   $8, $fp, " << itr->second << "\n";
-		dst << "    sw      $8, " << stack_offsets.at(itr->first) << "($fp)\n";
+		code << "    addiu   $8, $fp, " << itr->second << "\n";
+		context.store_variable(code, itr->first, 8);
 	}
 
 	// emit code
-	dst << "  fnc_" << function_name << "_code:\n";
-	for(IRVector::const_iterator itr = out.begin(); itr != out.end(); ++itr) {
-		(*itr)->PrintMIPS(dst, context, buff);
-	}
+	code << body.str();
+
+	code << epilogue.str();
+	code << "    j       $31\n"; // jump to return address
+	code << "    nop\n"; // delay slot
 
-	dst << "  fnc_" << function_name << "_return:\n";
-	dst << "    move    $sp, $fp\n"; // get back the base stack pointer
-	dst << "    lw      $31, " << (stack_size - 8) << "($sp)" << "\n"; // load return address
-	dst << "    lw      $fp, " << (stack_size - 4) << "($sp)" << "\n"; // load previous frame pointer
-	dst << "    addiu   $sp, $sp, " << stack_size << "\n"; // release allocated stack
-	dst << "    j       $31\n"; // jump to return address
-	dst << "    nop\n"; // delay slot
+	code << "\n";
 
-	dst << "\n";
+	// run the machine passes before printing
+	MachineCode machine_code = parse_assembly(code.str());
+	if(trim_frame) pass_manager().print_after("frame-elision", function_name, machine_code);
+	pass_manager().run(function_name, machine_code);
+	print_assembly(dst, machine_code);
 }
@@ -2,6 +2,7 @@
 #define AST_FUNCTION_H
 
 #include <iostream>
+#include <map>
 #include <vector>
 
 #include "Node.hpp"
@@ -12,6 +13,7 @@
 class Function : public Scope {
 
 	void make_instructions(VariableMap& bindings, FunctionStack& stack, IRVector& out) const;
+	void inline_calls(VariableMap const& globals, FunctionStack& stack, IRVector& out) const;
 
 protected:
 
@@ -23,14 +25,37 @@ public:
 	std::vector<Declaration*> parameters;
 	bool prototype_only;
 	bool has_ellipsis;
+	// declared inline: worth copying into callers even when not tiny
+	bool inline_hint;
 
 	void merge_parameters(Scope* scope);
+	// the return type from the declaration specifiers, less any inline
+	void set_return_type(std::vector<std::string> specifiers, int pointer_depth);
+
+	// the function's IR straight from the syntax tree, before any pass has run
+	void lower(VariableMap& bindings, FunctionStack& stack, IRVector& out) const;
 
 	virtual void Debug(std::ostream& dst, int indent) const;
 	virtual void PrintXML(std::ostream& dst, int indent) const;
 
 	virtual void CompileIR(VariableMap globals, std::ostream& dst) const;
+	virtual void CompileCFG(VariableMap globals, std::ostream& dst) const;
 	virtual void CompileMIPS(VariableMap globals, std::ostream& dst, std::ostream& buff) const;
 };
 
+// what the inliner knows about every function defined in the program
+struct FunctionDefinition {
+	Function const* function;
+	// calls to it from anywhere in the program
+	unsigned call_sites;
+	// its lowered size, see inline_cost
+	unsigned cost;
+	bool inlinable;
+};
+
+typedef std::map<std::string, FunctionDefinition> DefinitionMap;
+
+// filled in by ProgramRoot before any function is compiled
+DefinitionMap& function_definitions();
+
 #endif
@@ -1,5 +1,8 @@
 #include "ProgramRoot.hpp"
 
+#include "../intrep/Inliner.hpp"
+#include "../intrep/PassManager.hpp"
+
 #include <cstdio>
 
 void ProgramRoot::Debug(std::ostream& dst, int indent) const {
@@ -91,6 +94,33 @@ void ProgramRoot::populate_functions(VariableMap& bindings) const {
 		}
 }
 
+// lower every function once to find its size and count the calls to it across the program
+void ProgramRoot::populate_definitions(VariableMap const& bindings) const {
+	DefinitionMap& definitions = function_definitions();
+	definitions.clear();
+	if(!pass_manager().enabled("inline")) return;
+
+	std::map<std::string, unsigned> call_sites;
+	for(std::vector<Function*>::const_iterator itr = functions.begin(); itr != functions.end(); ++itr) {
+		VariableMap function_bindings = bindings;
+		FunctionStack stack;
+		IRVector code;
+		(*itr)->lower(function_bindings, stack, code);
+
+		FunctionDefinition d = { *itr, 0, inline_cost(code), is_inlinable(code) };
+		definitions[(*itr)->function_name] = d;
+		for(IRVector::const_iterator i = code.begin(); i != code.end(); ++i) {
+			if(FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(*i)) {
+				call_sites[call->get_function_name()]++;
+			}
+			delete *i;
+		}
+	}
+	for(DefinitionMap::iterator itr = definitions.begin(); itr != definitions.end(); ++itr) {
+		itr->second.call_sites = call_sites[itr->first];
+	}
+}
+
 void ProgramRoot::CompileIR(std::ostream &dst) const {
 	dst << std::endl << "# Intermediate representation generated using lscc" << std::endl << std::endl;
 
@@ -116,6 +146,7 @@ void ProgramRoot::CompileIR(std::ostream &dst) const {
 
 	// populate map with function names
 	populate_functions(global_bindings);
+	populate_definitions(global_bindings);
 
 	// generate code for every function
 	dst << std::endl;
@@ -125,6 +156,21 @@ void ProgramRoot::CompileIR(std::ostream &dst) const {
 	}
 }
 
+void ProgramRoot::CompileCFG(std::ostream &dst) const {
+	dst << std::endl << "# Control flow graph generated using lscc" << std::endl << std::endl;
+
+	VariableMap global_bindings;
+	ArrayMap arrays;
+
+	populate_declarations(global_bindings, arrays);
+	populate_functions(global_bindings);
+	populate_definitions(global_bindings);
+
+	for(std::vector<Function*>::const_iterator itr = functions.begin(); itr != functions.end(); ++itr) {
+		(*itr)->CompileCFG(global_bindings, dst);
+	}
+}
+
 
 void ProgramRoot::CompileMIPS(std::ostream &dst) const {
 	dst << std::endl << "# MIPS assembly generated using lscc" << std::endl << std::endl;
@@ -184,6 +230,7 @@ void ProgramRoot::CompileMIPS(std::ostream &dst) const {
 	}
 
 	populate_functions(global_bindings);
+	populate_definitions(global_bindings);
 
 	// generate code for every function
 	std::stringstream codeout, buff;
@@ -13,6 +13,7 @@ class ProgramRoot : public Scope {
 
 	void populate_declarations(VariableMap& bindings, ArrayMap& arrays) const;
 	void populate_functions(VariableMap& bindings) const;
+	void populate_definitions(VariableMap const& bindings) const;
 
 protected:
 	std::vector<Function*> functions;
@@ -24,6 +25,7 @@ public:
 	void add(Node* node);
 
 	void CompileIR(std::ostream& dst) const;
+	void CompileCFG(std::ostream& dst) const;
 	void CompileMIPS(std::ostream& dst) const;
 };
 
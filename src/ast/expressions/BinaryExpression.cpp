@@ -90,19 +90,32 @@ Type BinaryExpression::GetType(VariableMap const& bindings) const {
 
 std::string BinaryExpression::MakeIR(VariableMap const& bindings, FunctionStack& stack, IRVector& out) const {
 
+	if(op == op_logicaland || op == op_logicalor) {
+		/*
+		  if !(left op right) goto lg_false
+		  lg_res = 1
+		  goto lg_end
+		lg_false:
+		  lg_res = 0
+		lg_end:
+		*/
+		std::string lg_label = unique(op == op_logicaland ? "lgand" : "lgor");
+		stack[lg_label + "_res"] = GetType(bindings);
+		MakeIR_branch(bindings, stack, out, lg_label + "_false", false);
+		out.push_back(new ConstantInstruction(lg_label + "_res", GetType(bindings), 1));
+		out.push_back(new GotoInstruction(lg_label + "_end"));
+		out.push_back(new LabelInstruction(lg_label + "_false"));
+		out.push_back(new ConstantInstruction(lg_label + "_res", GetType(bindings), 0));
+		out.push_back(new LabelInstruction(lg_label + "_end"));
+		return lg_label + "_res";
+	}
+
 	std::string src1 = left->MakeIR(bindings, stack, out);
 	std::string src2 = right->MakeIR(bindings, stack, out);
 	std::string dst;
 	Instruction* instr = NULL;
 
-	if(op == op_logicaland) {
-		dst = unique("lgand");
-		instr = new LogicalInstruction(dst, src1, src2, '&');
-	} else if(op == op_logicalor) {
-		dst = unique("lgor");
-		instr = new LogicalInstruction(dst, src1, src2, '|');
-
-	} else if(op == op_bitwiseand) {
+	if(op == op_bitwiseand) {
 		dst = unique("bw_and");
 		instr = new BitwiseInstruction(dst, src1, src2, '&');
 	} else if(op == op_bitwiseor) {
@@ -164,6 +177,50 @@ std::string BinaryExpression::MakeIR(VariableMap const& bindings, FunctionStack&
 	}
 }
 
+void BinaryExpression::MakeIR_branch(VariableMap const& bindings, FunctionStack& stack, IRVector& out, std::string label, bool jump_if) const {
+	// short circuit: the right operand is only evaluated when the left one does not decide
+	if(op == op_logicaland || op == op_logicalor) {
+		// jumping when "a && b" is false or "a || b" is true needs no label of its own
+		bool decides = (op == op_logicalor);
+		if(jump_if == decides) {
+			left->MakeIR_branch(bindings, stack, out, label, jump_if);
+			right->MakeIR_branch(bindings, stack, out, label, jump_if);
+		} else {
+			std::string skip_label = unique(op == op_logicaland ? "lgand" : "lgor") + "_skip";
+			left->MakeIR_branch(bindings, stack, out, skip_label, decides);
+			right->MakeIR_branch(bindings, stack, out, label, jump_if);
+			out.push_back(new LabelInstruction(skip_label));
+		}
+		return;
+	}
+
+	// relation tested by the jump, and the one that jumps when it does not hold
+	char relation, inverse;
+	switch (op) {
+		case op_equals: relation = '='; inverse = '!'; break;
+		case op_notequals: relation = '!'; inverse = '='; break;
+		case op_lessthan: relation = '<'; inverse = 'g'; break;
+		case op_morethan: relation = '>'; inverse = 'l'; break;
+		case op_lessequal: relation = 'l'; inverse = '>'; break;
+		case op_moreequal: relation = 'g'; inverse = '<'; break;
+		default:
+			Expression::MakeIR_branch(bindings, stack, out, label, jump_if);
+			return;
+	}
+
+	// floats keep the 0/1 result: the inverse of a comparison is not a comparison once NaNs are involved
+	Type l = left->GetType(bindings);
+	Type r = right->GetType(bindings);
+	if(!(l.is_integer() || l.is_pointer()) || !(r.is_integer() || r.is_pointer())) {
+		Expression::MakeIR_branch(bindings, stack, out, label, jump_if);
+		return;
+	}
+
+	std::string src1 = left->MakeIR(bindings, stack, out);
+	std::string src2 = right->MakeIR(bindings, stack, out);
+	out.push_back(new GotoIfInstruction(label, src1, src2, jump_if ? relation : inverse));
+}
+
 std::string BinaryExpression::MakeIR_lvalue(VariableMap const& bindings, FunctionStack& stack, IRVector& out) const {
 	throw compile_error("cannot use binary operators within an l-value", sourceFile, sourceLine);
 }
@@ -40,6 +40,7 @@ public:
 
 	virtual std::string MakeIR(VariableMap const& bindings, FunctionStack& stack, IRVector& out) const;
 	virtual std::string MakeIR_lvalue(VariableMap const& bindings, FunctionStack& stack, IRVector& out) const;
+	virtual void MakeIR_branch(VariableMap const& bindings, FunctionStack& stack, IRVector& out, std::string label, bool jump_if) const;
 
 	virtual int32_t evaluate_int(VariableMap const& bindings) const;
 };
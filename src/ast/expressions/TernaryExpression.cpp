@@ -27,8 +27,7 @@ std::string TernaryExpression::MakeIR(VariableMap const& bindings, FunctionStack
 	std::string if_label = unique("if");
 	stack[if_label + "_res"] = GetType(bindings);
 	out.push_back(new LabelInstruction(if_label + "_begin"));					// if_begin:
-	std::string cond_res = condition->MakeIR(bindings, stack, out);				// condition
-	out.push_back(new GotoIfEqualInstruction(if_label + "_false", cond_res, 0)); // beqz if_false
+	condition->MakeIR_branch(bindings, stack, out, if_label + "_false", false);	// if !condition goto if_false
 	out.push_back(new LabelInstruction(if_label + "_true"));					// if_true:
 	std::string t_res = true_branch->MakeIR(bindings, stack, out);				// true_branch
 	out.push_back(new MoveInstruction(if_label + "_res", t_res));				// move to result
@@ -170,6 +170,15 @@ std::string UnaryExpression::MakeIR_lvalue(VariableMap const& bindings, Function
 	}
 }
 
+void UnaryExpression::MakeIR_branch(VariableMap const& bindings, FunctionStack& stack, IRVector& out, std::string label, bool jump_if) const {
+	if(op == op_logicalnot) {
+		// !x jumps exactly when x does not
+		expression->MakeIR_branch(bindings, stack, out, label, !jump_if);
+	} else {
+		Expression::MakeIR_branch(bindings, stack, out, label, jump_if);
+	}
+}
+
 int32_t UnaryExpression::evaluate_int(VariableMap const& bindings) const {
 	int32_t e = expression->evaluate_int(bindings);
 	switch (op) {
@@ -39,8 +39,7 @@ void IfStatement::MakeIR(VariableMap const& bindings, FunctionStack& stack, IRVe
 	if(!condition) { throw compile_error("empty if condition"); }
 	/*
 	if_begin:
-	  condition
-	  beqz if_false
+	  if !condition goto if_false
 	if_true:
 	  true_branch
 	  goto if_end
@@ -49,8 +48,7 @@ void IfStatement::MakeIR(VariableMap const& bindings, FunctionStack& stack, IRVe
 	if_end:
 	*/
 	out.push_back(new LabelInstruction(if_label + "_begin"));					// if_begin:
-	std::string cond_res = condition->MakeIR(bindings, stack, out);				// condition
-	out.push_back(new GotoIfEqualInstruction(if_label + "_false", cond_res, 0)); // beqz if_false
+	condition->MakeIR_branch(bindings, stack, out, if_label + "_false", false);	// if !condition goto if_false
 	out.push_back(new LabelInstruction(if_label + "_true"));					// if_true:
 	if(true_body) true_body->MakeIR(bindings, stack, out);						// true_branch
 	out.push_back(new GotoInstruction(if_label + "_end"));						// goto if_end
@@ -74,15 +74,8 @@ void SwitchStatement::MakeIR(VariableMap const& bindings, FunctionStack& stack,
 		}
 	}
 
-	// compare the switch expression against each value in the map
-	for(std::map<int32_t, std::string>::const_iterator itr = case_map.begin(); itr != case_map.end(); ++itr) {
-		out.push_back(new GotoIfEqualInstruction(itr->second, val, itr->first));
-	}
-	if(has_default) {
-		out.push_back(new GotoInstruction(switch_base + "_default"));
-	} else {
-		out.push_back(new GotoInstruction(switch_base + "_end"));
-	}
+	// dispatch on the switch expression: a jump table when the cases are dense, a binary search otherwise
+	out.push_back(new SwitchInstruction(val, case_map, switch_base + (has_default ? "_default" : "_end")));
 
 	// execute the statements, replacing cases with their labels
 	out.push_back(new LabelInstruction(switch_base + "_body"));
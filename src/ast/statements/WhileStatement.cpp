@@ -26,8 +26,8 @@ void WhileStatement::PrintXML(std::ostream& dst, int indent) const {
 void WhileStatement::MakeIR(VariableMap const& bindings, FunctionStack& stack, IRVector& out) const {
 	/*
 	while_begin:
-	  condition
-	  beqz while_end
+	while_condition:
+	  if !condition goto while_end
 	  body
 	  goto while_begin
 	while_end:
@@ -36,9 +36,8 @@ void WhileStatement::MakeIR(VariableMap const& bindings, FunctionStack& stack, I
 	/*
 	while_begin:
 	  body
-	  condition
-	  beqz while_end
-	  goto while_begin
+	while_condition:
+	  if condition goto while_begin
 	while_end:
 	*/
 
@@ -58,13 +57,15 @@ void WhileStatement::MakeIR(VariableMap const& bindings, FunctionStack& stack, I
 	}
 
 	out.push_back(new LabelInstruction(while_label + "_condition"));
-	std::string cond_res = expression->MakeIR(while_bindings, stack, out); //condition
-	out.push_back(new GotoIfEqualInstruction(while_label + "_end", cond_res, 0)); //beqz
-
-	if(!statement_before_condition) { // while() {}
+	if(statement_before_condition) {
+		// do {} while(): loop back while the condition holds
+		expression->MakeIR_branch(while_bindings, stack, out, while_label + "_begin", true);
+	} else {
+		// while() {}: leave once it does not
+		expression->MakeIR_branch(while_bindings, stack, out, while_label + "_end", false);
 		if(statement) statement->MakeIR(while_bindings, stack, out);
+		out.push_back(new GotoInstruction(while_label + "_begin"));
 	}
 
-	out.push_back(new GotoInstruction(while_label + "_begin"));
 	out.push_back(new LabelInstruction(while_label + "_end"));
 }
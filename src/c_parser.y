@@ -29,7 +29,7 @@
 }
 
 %token TVOID TLONG TSHORT TCHAR TINT TFLOAT TDOUBLE UNSIGNED SIGNED
-%token AUTO CONST EXTERN REGISTER STATIC VOLATILE
+%token AUTO CONST EXTERN REGISTER STATIC VOLATILE INLINE
 %token STRUCT TYPEDEF UNION ENUM
 %token IF ELSE WHILE DO FOR
 %token GOTO BREAK CONTINUE RETURN
@@ -100,7 +100,7 @@ TopLevelDeclaration : DeclarationSpecifiers DeclarationList ';' {
 						dynamic_cast<Function*>$$->function_name = dynamic_cast<Declaration*>$2->identifier;
 
 						// set the type
-						dynamic_cast<Function*>$$->return_type = Type(*$1, dynamic_cast<Declaration*>$2->var_type.pointer_depth);
+						dynamic_cast<Function*>$$->set_return_type(*$1, dynamic_cast<Declaration*>$2->var_type.pointer_depth);
 					}
 					| DeclarationSpecifiers Declarator '(' FunctionParameterList ')' ';' {
 						// function declaration
@@ -111,7 +111,7 @@ TopLevelDeclaration : DeclarationSpecifiers DeclarationList ';' {
 						dynamic_cast<Function*>$$->function_name = dynamic_cast<Declaration*>$2->identifier;
 
 						// set the type
-						dynamic_cast<Function*>$$->return_type = Type(*$1, dynamic_cast<Declaration*>$2->var_type.pointer_depth);
+						dynamic_cast<Function*>$$->set_return_type(*$1, dynamic_cast<Declaration*>$2->var_type.pointer_depth);
 
 						// transfer the parameter list
 						dynamic_cast<Function*>$$->merge_parameters(dynamic_cast<Scope*>$4);
@@ -126,7 +126,7 @@ TopLevelDeclaration : DeclarationSpecifiers DeclarationList ';' {
 						dynamic_cast<Function*>$$->function_name = dynamic_cast<Declaration*>$2->identifier;
 
 						// set the type
-						dynamic_cast<Function*>$$->return_type = Type(*$1, dynamic_cast<Declaration*>$2->var_type.pointer_depth);
+						dynamic_cast<Function*>$$->set_return_type(*$1, dynamic_cast<Declaration*>$2->var_type.pointer_depth);
 
 						// transfer the parameter list
 						dynamic_cast<Function*>$$->merge_parameters(dynamic_cast<Scope*>$4);
@@ -135,7 +135,7 @@ TopLevelDeclaration : DeclarationSpecifiers DeclarationList ';' {
 						// function definition
 						$$ = $2;
 						// add in the specifiers for the function type
-						dynamic_cast<Function*>$$->return_type = Type(*$1, dynamic_cast<Function*>$$->return_type.pointer_depth);
+						dynamic_cast<Function*>$$->set_return_type(*$1, dynamic_cast<Function*>$$->return_type.pointer_depth);
 					}
 					| DeclarationSpecifiers ';' {
 						// this is for the benefit of named structs/unions/enums with no instances
@@ -175,6 +175,7 @@ TypeSpecifier	: TVOID { $$ = strdup("void"); }
 				| VOLATILE { $$ = NULL; }
 				| EXTERN { $$ = NULL; }
 				| STATIC { $$ = NULL; }
+				| INLINE { $$ = strdup("inline"); }
 				| AUTO { $$ = NULL; }
 				| REGISTER { $$ = NULL; }
 				| StructureDeclaration { $$ = $1; }
@@ -33,3 +33,6 @@
 #include "ast/TypeSuffix.hpp"
 
 #include "intrep/Type.hpp"
+#include "intrep/Peephole.hpp"
+#include "intrep/Scheduler.hpp"
+#include "intrep/PassManager.hpp"
@@ -0,0 +1,87 @@
+#include "AddressFolding.hpp"
+
+#include "ControlFlowGraph.hpp"
+#include "Liveness.hpp"
+
+// *******************************************
+
+// what a pointer variable holds: base + offset, where a direct base is the address of a variable
+struct FoldedAddress {
+	std::string base;
+	int32_t offset;
+	bool direct;
+};
+
+typedef std::map<std::string, FoldedAddress> AddressMap;
+
+// pointers whose value only changes where the IR writes them
+static bool is_stable(FunctionStack const& stack, std::set<std::string> const& address_taken, std::string name) {
+	return stack.count(name) && !address_taken.count(name) && stack.at(name).is_pointer();
+}
+
+// the address instruction leaves in its destination, false if it is not base + constant
+static bool folded_address(Instruction const* instruction, FunctionStack const& stack,
+	std::set<std::string> const& address_taken, AddressMap const& known, FoldedAddress& result) {
+	if(AddressOfInstruction const* a = dynamic_cast<AddressOfInstruction const*>(instruction)) {
+		result.base = a->get_variable();
+		result.offset = 0;
+		result.direct = true;
+		return true;
+	}
+	std::string base;
+	int32_t offset;
+	if(!instruction->address_offset(stack, base, offset)) return false;
+	AddressMap::const_iterator itr = known.find(base);
+	if(itr != known.end()) {
+		result = itr->second;
+	} else if(is_stable(stack, address_taken, base)) {
+		result.base = base;
+		result.offset = 0;
+		result.direct = false;
+	} else {
+		return false;
+	}
+	// the displacement field of a load or store is 16 bits
+	int64_t total = (int64_t)result.offset + offset;
+	if(total < -32768 || total > 32767) return false;
+	result.offset = (int32_t)total;
+	return true;
+}
+
+// *******************************************
+
+void fold_addresses(IRVector& code, FunctionStack& stack) {
+	std::set<std::string> address_taken = address_taken_variables(code);
+	ControlFlowGraph cfg(code);
+
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector& instructions = cfg.blocks.at(b).instructions;
+		AddressMap known;
+		for(IRVector::iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			Instruction* instruction = *itr;
+			if(DereferenceInstruction* load = dynamic_cast<DereferenceInstruction*>(instruction)) {
+				AddressMap::const_iterator a = known.find(load->get_pointer());
+				if(a != known.end()) load->fold_address(a->second.base, a->second.offset, a->second.direct);
+			} else if(AssignInstruction* store = dynamic_cast<AssignInstruction*>(instruction)) {
+				AddressMap::const_iterator a = known.find(store->get_pointer());
+				if(a != known.end()) store->fold_address(a->second.base, a->second.offset, a->second.direct, stack);
+			}
+
+			std::string d = instruction->get_destination();
+			if(d == "") continue;
+			FoldedAddress address;
+			bool folds = is_stable(stack, address_taken, d) && folded_address(instruction, stack, address_taken, known, address);
+			// whatever was worked out from the old value of d no longer holds
+			known.erase(d);
+			for(AddressMap::iterator k = known.begin(); k != known.end(); ) {
+				if(!k->second.direct && k->second.base == d) {
+					known.erase(k++);
+				} else {
+					++k;
+				}
+			}
+			if(folds) known[d] = address;
+		}
+	}
+	code = cfg.flatten();
+}
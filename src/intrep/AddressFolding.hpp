@@ -0,0 +1,12 @@
+#ifndef IR_ADDRESS_FOLDING_H
+#define IR_ADDRESS_FOLDING_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// let loads and stores through a pointer that is a known base plus a constant
+// (a struct member, a constant index, the address of a local) use that base and
+// the constant as their displacement, leaving the address computation dead
+void fold_addresses(IRVector& code, FunctionStack& stack);
+
+#endif
@@ -0,0 +1,175 @@
+#include "ConstantFolding.hpp"
+
+#include "ControlFlowGraph.hpp"
+#include "Liveness.hpp"
+
+// *******************************************
+
+// variables whose every write is visible in the IR: no address taken, integer, not global
+static bool is_tracked(FunctionStack const& stack, std::set<std::string> const& address_taken, std::string name) {
+	if(name == "" || !stack.count(name) || address_taken.count(name)) return false;
+	Type t = stack.at(name);
+	return t.is_integer() && t.bytes() <= 4;
+}
+
+static void transfer(Instruction const* instruction, FunctionStack const& stack,
+	std::set<std::string> const& address_taken, ConstantValues& state) {
+	std::string d = instruction->get_destination();
+	if(d == "") return;
+	int32_t value;
+	if(is_tracked(stack, address_taken, d) && instruction->evaluate(state, stack, value)) {
+		state[d] = value;
+	} else {
+		state.erase(d);
+	}
+}
+
+// values that agree on every incoming path
+static ConstantValues meet(ConstantValues const& a, ConstantValues const& b) {
+	ConstantValues result;
+	for(ConstantValues::const_iterator itr = a.begin(); itr != a.end(); ++itr) {
+		ConstantValues::const_iterator other = b.find(itr->first);
+		if(other != b.end() && other->second == itr->second) {
+			result.insert(*itr);
+		}
+	}
+	return result;
+}
+
+// *******************************************
+
+/*
+ * Optimistic propagation: a block only counts once a taken edge reaches it, and
+ * a jump on a known condition only takes one of its edges.  Leaves what is known
+ * on entry to every block in `in`.
+ */
+static void propagate(ControlFlowGraph const& cfg, FunctionStack const& stack, std::set<std::string> const& address_taken,
+	std::vector<ConstantValues>& in, std::vector<bool>& reached) {
+	unsigned n = cfg.blocks.size();
+	in.assign(n, ConstantValues());
+	reached.assign(n, false);
+	std::vector<ConstantValues> out(n);
+	std::vector<std::set<unsigned> > taken(n);
+	if(n == 0) return;
+	reached.at(0) = true;
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(unsigned b = 0; b < n; b++) {
+			if(!reached.at(b)) continue;
+			BasicBlock const& block = cfg.blocks.at(b);
+
+			ConstantValues state;
+			bool first = true;
+			if(b != 0) {
+				for(std::vector<unsigned>::const_iterator p = block.predecessors.begin(); p != block.predecessors.end(); ++p) {
+					if(!reached.at(*p) || !taken.at(*p).count(b)) continue;
+					state = first ? out.at(*p) : meet(state, out.at(*p));
+					first = false;
+				}
+			}
+			in.at(b) = state;
+			for(IRVector::const_iterator itr = block.instructions.begin(); itr != block.instructions.end(); ++itr) {
+				transfer(*itr, stack, address_taken, state);
+			}
+
+			std::set<unsigned> edges(block.successors.begin(), block.successors.end());
+			GotoIfInstruction* branch = block.instructions.empty() ? NULL : dynamic_cast<GotoIfInstruction*>(block.instructions.back());
+			bool jumps;
+			if(branch && block.successors.size() == 2 && branch->evaluate_condition(state, stack, jumps)) {
+				edges.clear();
+				edges.insert(jumps ? cfg.find_block(branch->get_label()) : b + 1);
+			}
+			SwitchInstruction* dispatch = block.instructions.empty() ? NULL : dynamic_cast<SwitchInstruction*>(block.instructions.back());
+			if(dispatch && state.count(dispatch->get_variable())) {
+				edges.clear();
+				edges.insert(cfg.find_block(dispatch->get_label(state.at(dispatch->get_variable()))));
+			}
+
+			if(state != out.at(b) || edges != taken.at(b)) {
+				out.at(b) = state;
+				taken.at(b) = edges;
+				changed = true;
+			}
+			for(std::set<unsigned>::const_iterator s = edges.begin(); s != edges.end(); ++s) {
+				if(!reached.at(*s)) {
+					reached.at(*s) = true;
+					changed = true;
+				}
+			}
+		}
+	}
+}
+
+// *******************************************
+
+void fold_constants(IRVector& code, FunctionStack& stack) {
+	std::set<std::string> address_taken = address_taken_variables(code);
+	ControlFlowGraph cfg(code);
+	unsigned n = cfg.blocks.size();
+	std::vector<ConstantValues> in;
+	std::vector<bool> reached;
+	propagate(cfg, stack, address_taken, in, reached);
+
+	// rewrite every reachable block with what is known on entry to it
+	for(unsigned b = 0; b < n; b++) {
+		if(!reached.at(b)) continue;
+		ConstantValues state = in.at(b);
+		IRVector& instructions = cfg.blocks.at(b).instructions;
+		IRVector result;
+		for(IRVector::iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			Instruction* instruction = *itr;
+			if(GotoIfInstruction* g = dynamic_cast<GotoIfInstruction*>(instruction)) {
+				bool taken;
+				if(g->evaluate_condition(state, stack, taken)) {
+					if(taken) {
+						result.push_back(new GotoInstruction(g->get_label()));
+					}
+					delete instruction;
+					continue;
+				}
+			}
+			if(SwitchInstruction* s = dynamic_cast<SwitchInstruction*>(instruction)) {
+				if(state.count(s->get_variable())) {
+					result.push_back(new GotoInstruction(s->get_label(state.at(s->get_variable()))));
+					delete instruction;
+					continue;
+				}
+			}
+			transfer(instruction, stack, address_taken, state);
+			std::string d = instruction->get_destination();
+			if(state.count(d) && !dynamic_cast<ConstantInstruction*>(instruction)) {
+				result.push_back(new ConstantInstruction(d, stack.at(d), state.at(d)));
+				delete instruction;
+				continue;
+			}
+			result.push_back(instruction);
+		}
+		instructions = result;
+	}
+	code = cfg.flatten();
+}
+
+void bind_immediates(IRVector& code, FunctionStack& stack) {
+	std::set<std::string> address_taken = address_taken_variables(code);
+	ControlFlowGraph cfg(code);
+	unsigned n = cfg.blocks.size();
+	std::vector<ConstantValues> in;
+	std::vector<bool> reached;
+	propagate(cfg, stack, address_taken, in, reached);
+
+	for(unsigned b = 0; b < n; b++) {
+		if(!reached.at(b)) continue;
+		ConstantValues state = in.at(b);
+		IRVector& instructions = cfg.blocks.at(b).instructions;
+		for(IRVector::iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			// binding rewrites the sources, so walk a copy
+			std::vector<std::string> sources = (*itr)->get_sources();
+			for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+				if(state.count(*s) && (*itr)->bind_immediate(*s, state.at(*s), stack)) break;
+			}
+			transfer(*itr, stack, address_taken, state);
+		}
+	}
+	code = cfg.flatten();
+}
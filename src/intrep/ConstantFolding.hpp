@@ -0,0 +1,16 @@
+#ifndef IR_CONSTANT_FOLDING_H
+#define IR_CONSTANT_FOLDING_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// propagate integer constants through the function's locals and temporaries,
+// replace everything they determine with constant instructions and resolve
+// conditional jumps whose condition is known
+void fold_constants(IRVector& code, FunctionStack& stack);
+
+// fold operands known to be small constants into the instructions that read
+// them, so they are emitted with the immediate forms (addiu, andi, slti, ...)
+void bind_immediates(IRVector& code, FunctionStack& stack);
+
+#endif
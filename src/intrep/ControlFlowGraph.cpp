@@ -0,0 +1,295 @@
+#include "ControlFlowGraph.hpp"
+
+#include <algorithm>
+#include <map>
+
+// *******************************************
+
+ControlFlowGraph::ControlFlowGraph(IRVector const& code) {
+	// split into blocks: a label starts one, a jump or return ends one
+	blocks.push_back(BasicBlock());
+	bool ended = false;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		if(LabelInstruction* l = dynamic_cast<LabelInstruction*>(*itr)) {
+			if(!blocks.back().instructions.empty()) {
+				blocks.push_back(BasicBlock());
+			}
+			blocks.back().label = l->get_name();
+			ended = false;
+		} else if(ended) {
+			blocks.push_back(BasicBlock());
+			ended = false;
+		}
+		blocks.back().instructions.push_back(*itr);
+		if(dynamic_cast<GotoInstruction*>(*itr) || dynamic_cast<GotoIfInstruction*>(*itr) || dynamic_cast<SwitchInstruction*>(*itr)
+			|| dynamic_cast<ReturnInstruction*>(*itr)) {
+			ended = true;
+		}
+	}
+	rebuild();
+}
+
+void ControlFlowGraph::rebuild() {
+	link_blocks();
+	compute_dominators();
+	find_loops();
+}
+
+IRVector ControlFlowGraph::flatten() const {
+	IRVector code;
+	for(std::vector<BasicBlock>::const_iterator itr = blocks.begin(); itr != blocks.end(); ++itr) {
+		code.insert(code.end(), itr->instructions.begin(), itr->instructions.end());
+	}
+	return code;
+}
+
+int ControlFlowGraph::find_block(std::string label) const {
+	for(unsigned i = 0; i < blocks.size(); i++) {
+		if(blocks.at(i).label == label) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool ControlFlowGraph::has_preheader_slot(NaturalLoop const& loop) const {
+	unsigned h = loop.header;
+	std::vector<unsigned> const& preds = blocks.at(h).predecessors;
+	for(std::vector<unsigned>::const_iterator p = preds.begin(); p != preds.end(); ++p) {
+		if(loop.blocks.count(*p)) continue;
+		if(*p + 1 != h) return false;
+		Instruction* last = blocks.at(*p).instructions.empty() ? NULL : blocks.at(*p).instructions.back();
+		GotoIfInstruction* branch = dynamic_cast<GotoIfInstruction*>(last);
+		if(dynamic_cast<GotoInstruction*>(last) || dynamic_cast<SwitchInstruction*>(last)) return false;
+		if(branch && branch->get_label() == blocks.at(h).label) return false;
+	}
+	// a loop block falling into the header would run it on every iteration
+	return h == 0 || loop.blocks.count(h - 1) == 0
+		|| std::find(preds.begin(), preds.end(), h - 1) == preds.end();
+}
+
+// *******************************************
+
+static void add_edge(std::vector<BasicBlock>& blocks, unsigned from, unsigned to) {
+	std::vector<unsigned>& succ = blocks.at(from).successors;
+	if(std::find(succ.begin(), succ.end(), to) == succ.end()) {
+		succ.push_back(to);
+		blocks.at(to).predecessors.push_back(from);
+	}
+}
+
+void ControlFlowGraph::link_blocks() {
+	std::map<std::string, unsigned> labels;
+	for(unsigned i = 0; i < blocks.size(); i++) {
+		blocks.at(i).predecessors.clear();
+		blocks.at(i).successors.clear();
+		if(blocks.at(i).label != "") {
+			labels[blocks.at(i).label] = i;
+		}
+	}
+	for(unsigned i = 0; i < blocks.size(); i++) {
+		Instruction* last = blocks.at(i).instructions.empty() ? NULL : blocks.at(i).instructions.back();
+		std::vector<std::string> targets;
+		bool falls_through = true;
+		if(GotoInstruction* g = dynamic_cast<GotoInstruction*>(last)) {
+			targets.push_back(g->get_label());
+			falls_through = false;
+		} else if(GotoIfInstruction* g = dynamic_cast<GotoIfInstruction*>(last)) {
+			targets.push_back(g->get_label());
+		} else if(SwitchInstruction* s = dynamic_cast<SwitchInstruction*>(last)) {
+			targets = s->get_labels();
+			falls_through = false;
+		} else if(dynamic_cast<ReturnInstruction*>(last)) {
+			falls_through = false;
+		}
+		for(std::vector<std::string>::const_iterator t = targets.begin(); t != targets.end(); ++t) {
+			if(!labels.count(*t)) {
+				throw compile_error((std::string)"IR: jump to undefined label " + *t);
+			}
+			add_edge(blocks, i, labels.at(*t));
+		}
+		if(falls_through && i + 1 < blocks.size()) {
+			add_edge(blocks, i, i + 1);
+		}
+	}
+}
+
+// *******************************************
+
+void ControlFlowGraph::compute_dominators() {
+	// depth first search for a postorder of the reachable blocks
+	postorder.clear();
+	std::vector<bool> visited(blocks.size(), false);
+	std::vector<std::pair<unsigned, unsigned> > dfs;
+	dfs.push_back(std::make_pair(0u, 0u));
+	visited.at(0) = true;
+	while(!dfs.empty()) {
+		unsigned b = dfs.back().first;
+		unsigned next = dfs.back().second;
+		if(next < blocks.at(b).successors.size()) {
+			dfs.back().second++;
+			unsigned s = blocks.at(b).successors.at(next);
+			if(!visited.at(s)) {
+				visited.at(s) = true;
+				dfs.push_back(std::make_pair(s, 0u));
+			}
+		} else {
+			postorder.push_back(b);
+			dfs.pop_back();
+		}
+	}
+	std::vector<int> order(blocks.size(), -1);
+	for(unsigned i = 0; i < postorder.size(); i++) {
+		order.at(postorder.at(i)) = i;
+	}
+
+	// iterative dominators (Cooper, Harvey and Kennedy)
+	idom.assign(blocks.size(), -1);
+	idom.at(0) = 0;
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(std::vector<unsigned>::const_reverse_iterator b = postorder.rbegin(); b != postorder.rend(); ++b) {
+			if(*b == 0) continue;
+			int new_idom = -1;
+			std::vector<unsigned> const& preds = blocks.at(*b).predecessors;
+			for(std::vector<unsigned>::const_iterator p = preds.begin(); p != preds.end(); ++p) {
+				if(idom.at(*p) == -1) continue;
+				if(new_idom == -1) {
+					new_idom = *p;
+					continue;
+				}
+				int x = *p, y = new_idom;
+				while(x != y) {
+					while(order.at(x) < order.at(y)) x = idom.at(x);
+					while(order.at(y) < order.at(x)) y = idom.at(y);
+				}
+				new_idom = x;
+			}
+			if(idom.at(*b) != new_idom) {
+				idom.at(*b) = new_idom;
+				changed = true;
+			}
+		}
+	}
+}
+
+bool ControlFlowGraph::is_reachable(unsigned block) const {
+	return idom.at(block) != -1;
+}
+
+int ControlFlowGraph::immediate_dominator(unsigned block) const {
+	if(block == 0) return -1;
+	return idom.at(block);
+}
+
+bool ControlFlowGraph::dominates(unsigned a, unsigned b) const {
+	if(!is_reachable(a) || !is_reachable(b)) return false;
+	while(b != a) {
+		if(b == 0) return false;
+		b = idom.at(b);
+	}
+	return true;
+}
+
+std::vector<unsigned> ControlFlowGraph::reverse_postorder() const {
+	return std::vector<unsigned>(postorder.rbegin(), postorder.rend());
+}
+
+// *******************************************
+
+void ControlFlowGraph::find_loops() {
+	// every edge to a dominating block closes a natural loop, one loop per header
+	loops.clear();
+	std::map<unsigned, unsigned> by_header;
+	for(unsigned b = 0; b < blocks.size(); b++) {
+		if(!is_reachable(b)) continue;
+		std::vector<unsigned> const& succ = blocks.at(b).successors;
+		for(std::vector<unsigned>::const_iterator h = succ.begin(); h != succ.end(); ++h) {
+			if(!dominates(*h, b)) continue;
+			if(!by_header.count(*h)) {
+				NaturalLoop loop;
+				loop.header = *h;
+				loop.blocks.insert(*h);
+				loop.parent = -1;
+				loop.depth = 1;
+				by_header[*h] = loops.size();
+				loops.push_back(loop);
+			}
+			NaturalLoop& loop = loops.at(by_header.at(*h));
+			loop.latches.push_back(b);
+			// walk backwards from the latch until the header
+			std::vector<unsigned> work;
+			if(loop.blocks.insert(b).second) work.push_back(b);
+			while(!work.empty()) {
+				unsigned x = work.back();
+				work.pop_back();
+				std::vector<unsigned> const& preds = blocks.at(x).predecessors;
+				for(std::vector<unsigned>::const_iterator p = preds.begin(); p != preds.end(); ++p) {
+					if(is_reachable(*p) && loop.blocks.insert(*p).second) work.push_back(*p);
+				}
+			}
+		}
+	}
+
+	// nesting: the parent is the smallest other loop containing this one's header
+	for(unsigned i = 0; i < loops.size(); i++) {
+		for(unsigned j = 0; j < loops.size(); j++) {
+			if(i == j || !loops.at(j).blocks.count(loops.at(i).header)) continue;
+			if(loops.at(j).blocks.size() <= loops.at(i).blocks.size()) continue;
+			if(loops.at(i).parent == -1 || loops.at(j).blocks.size() < loops.at(loops.at(i).parent).blocks.size()) {
+				loops.at(i).parent = j;
+			}
+		}
+	}
+	for(unsigned i = 0; i < loops.size(); i++) {
+		unsigned depth = 1;
+		for(int p = loops.at(i).parent; p != -1; p = loops.at(p).parent) depth++;
+		loops.at(i).depth = depth;
+	}
+
+	for(unsigned b = 0; b < blocks.size(); b++) {
+		blocks.at(b).loop_depth = 0;
+	}
+	for(std::vector<NaturalLoop>::const_iterator l = loops.begin(); l != loops.end(); ++l) {
+		for(std::set<unsigned>::const_iterator b = l->blocks.begin(); b != l->blocks.end(); ++b) {
+			blocks.at(*b).loop_depth++;
+		}
+	}
+}
+
+// *******************************************
+
+static void print_list(std::ostream& dst, std::vector<unsigned> const& list) {
+	if(list.empty()) {
+		dst << " -";
+	}
+	for(std::vector<unsigned>::const_iterator itr = list.begin(); itr != list.end(); ++itr) {
+		dst << " b" << *itr;
+	}
+}
+
+void ControlFlowGraph::Debug(std::ostream& dst) const {
+	for(unsigned i = 0; i < blocks.size(); i++) {
+		BasicBlock const& b = blocks.at(i);
+		dst << "    # b" << i;
+		if(i == 0) dst << " (entry)";
+		if(!is_reachable(i)) dst << " (unreachable)";
+		dst << " preds:";
+		print_list(dst, b.predecessors);
+		dst << " succs:";
+		print_list(dst, b.successors);
+		dst << " idom: ";
+		if(immediate_dominator(i) == -1) dst << "-"; else dst << "b" << immediate_dominator(i);
+		dst << " loop depth: " << b.loop_depth << std::endl;
+		for(IRVector::const_iterator itr = b.instructions.begin(); itr != b.instructions.end(); ++itr) {
+			(*itr)->Debug(dst);
+		}
+	}
+	for(std::vector<NaturalLoop>::const_iterator l = loops.begin(); l != loops.end(); ++l) {
+		dst << "    # loop b" << l->header << " depth " << l->depth << " blocks:";
+		print_list(dst, std::vector<unsigned>(l->blocks.begin(), l->blocks.end()));
+		if(l->parent != -1) dst << " in loop b" << loops.at(l->parent).header;
+		dst << std::endl;
+	}
+}
@@ -0,0 +1,72 @@
+#ifndef IR_CONTROL_FLOW_GRAPH_H
+#define IR_CONTROL_FLOW_GRAPH_H
+
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Instruction.hpp"
+
+// *******************************************
+
+struct BasicBlock {
+	// label the block starts with ("" for the entry or a fall-through block)
+	std::string label;
+	IRVector instructions;
+
+	std::vector<unsigned> predecessors;
+	std::vector<unsigned> successors;
+
+	// number of loops this block sits in
+	unsigned loop_depth;
+
+	BasicBlock() : loop_depth(0) {}
+};
+
+struct NaturalLoop {
+	unsigned header;
+	std::set<unsigned> blocks;
+	// blocks jumping back to the header
+	std::vector<unsigned> latches;
+	// innermost enclosing loop, -1 if outermost
+	int parent;
+	unsigned depth;
+};
+
+// *******************************************
+
+class ControlFlowGraph {
+	std::vector<int> idom;
+	std::vector<unsigned> postorder;
+
+	void link_blocks();
+	void compute_dominators();
+	void find_loops();
+
+public:
+	// block 0 is the entry
+	std::vector<BasicBlock> blocks;
+	std::vector<NaturalLoop> loops;
+
+	ControlFlowGraph(IRVector const& code);
+
+	// recompute edges, dominators and loops after blocks have been edited
+	void rebuild();
+	// instructions back in block order
+	IRVector flatten() const;
+
+	bool is_reachable(unsigned block) const;
+	int immediate_dominator(unsigned block) const;
+	bool dominates(unsigned a, unsigned b) const;
+	// reachable blocks, each after all of its forward-edge predecessors
+	std::vector<unsigned> reverse_postorder() const;
+	int find_block(std::string label) const;
+	// whether a block placed just before the loop header would run once each time the
+	// loop is entered: the only way in from outside is falling through from that spot
+	bool has_preheader_slot(NaturalLoop const& loop) const;
+
+	void Debug(std::ostream& dst) const;
+};
+
+#endif
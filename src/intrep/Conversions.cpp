@@ -175,3 +175,19 @@ void convert_type(std::ostream &out, unsigned s_reg, Type s_type, unsigned d_reg
 	// no conversion is possible
 	throw compile_error((std::string)"type mismatch: '" + s_type.name() + "' cannot be converted to '" + d_type.name() + "'");
 }
+
+int32_t convert_constant(int32_t value, Type d_type) {
+	// truncate to the destination, then sign or zero extend as lb/lbu/lh/lhu would
+	switch (d_type.is_integer() ? d_type.builtin_type : Type::SignedInt) {
+		case Type::SignedChar:
+			return (int8_t)value;
+		case Type::UnsignedChar:
+			return (uint8_t)value;
+		case Type::SignedShort:
+			return (int16_t)value;
+		case Type::UnsignedShort:
+			return (uint16_t)value;
+		default:
+			return value;
+	}
+}
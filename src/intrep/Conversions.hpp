@@ -1,10 +1,15 @@
 #ifndef IR_CONVERSIONS_H
 #define IR_CONVERSIONS_H
 
+#include <stdint.h>
+
 #include "Type.hpp"
 
 Type arithmetic_conversion(Type a, Type b);
 
 void convert_type(std::ostream &out, unsigned s_reg, Type s_type, unsigned d_reg, Type d_type);
 
+// the integer conversions of convert_type applied to a value known at compile time
+int32_t convert_constant(int32_t value, Type d_type);
+
 #endif
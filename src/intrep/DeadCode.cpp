@@ -0,0 +1,85 @@
+#include "DeadCode.hpp"
+
+#include "ControlFlowGraph.hpp"
+#include "Liveness.hpp"
+
+// *******************************************
+
+static void remove_unreachable_blocks(IRVector& code) {
+	ControlFlowGraph cfg(code);
+	IRVector result;
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector const& instructions = cfg.blocks.at(b).instructions;
+		if(cfg.is_reachable(b)) {
+			result.insert(result.end(), instructions.begin(), instructions.end());
+		} else {
+			for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+				delete *itr;
+			}
+		}
+	}
+	code = result;
+}
+
+// one backwards sweep over every block, returns whether anything was removed
+static bool remove_dead_instructions(IRVector& code, FunctionStack const& stack) {
+	ControlFlowGraph cfg(code);
+	Liveness liveness(cfg, stack);
+	std::set<std::string> address_taken = address_taken_variables(code);
+	bool changed = false;
+
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector& instructions = cfg.blocks.at(b).instructions;
+		std::set<std::string> live = liveness.live_out.at(b);
+		for(unsigned i = instructions.size(); i-- > 0; ) {
+			Instruction* instruction = instructions.at(i);
+			std::string d = instruction->get_destination();
+			// writes to globals, parameters and anything a pointer can reach stay
+			bool dead = d != "" && stack.count(d) && !address_taken.count(d) && !live.count(d);
+			if(dead) {
+				if(FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(instruction)) {
+					// the call itself has to happen, only its result is thrown away
+					instructions.at(i) = new FunctionCallInstruction("", call->get_function_name(), call->get_arguments());
+					delete call;
+					instruction = instructions.at(i);
+				} else {
+					delete instruction;
+					instructions.erase(instructions.begin() + i);
+					changed = true;
+					continue;
+				}
+			}
+			if(d != "") live.erase(d);
+			std::vector<std::string> sources = instruction->get_sources();
+			live.insert(sources.begin(), sources.end());
+		}
+	}
+	code = cfg.flatten();
+	return changed;
+}
+
+// *******************************************
+
+void eliminate_dead_code(IRVector& code, FunctionStack& stack) {
+	remove_unreachable_blocks(code);
+	while(remove_dead_instructions(code, stack));
+
+	// variables (and local arrays) nothing refers to any more need no storage
+	std::set<std::string> referenced;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		std::vector<std::string> sources = (*itr)->get_sources();
+		referenced.insert(sources.begin(), sources.end());
+		referenced.insert((*itr)->get_destination());
+		if((*itr)->get_addressed_variable() != "") {
+			referenced.insert((*itr)->get_addressed_variable());
+		}
+	}
+	for(FunctionStack::iterator itr = stack.begin(); itr != stack.end(); ) {
+		if(referenced.count(itr->first)) {
+			++itr;
+		} else {
+			stack.arrays.erase(itr->first);
+			stack.erase(itr++);
+		}
+	}
+}
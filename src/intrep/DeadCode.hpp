@@ -0,0 +1,11 @@
+#ifndef IR_DEAD_CODE_H
+#define IR_DEAD_CODE_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// drop blocks that cannot be reached from the entry and instructions whose
+// results are never read, then forget the variables nothing refers to any more
+void eliminate_dead_code(IRVector& code, FunctionStack& stack);
+
+#endif
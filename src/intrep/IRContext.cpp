@@ -6,12 +6,14 @@
 IRContext::IRContext(VariableMap const& globals,
 	FunctionStack const& stack,
 	std::map<std::string, unsigned> const& stack_offsets,
+	std::map<std::string, unsigned> const& registers,
 	std::string func_name,
 	Type return_type,
 	unsigned return_struct_offset)
 : globals(globals),
 stack(stack),
 stack_offsets(stack_offsets),
+registers(registers),
 func_name(func_name),
 return_type(return_type),
 return_struct_offset(return_struct_offset) {}
@@ -28,6 +30,18 @@ unsigned IRContext::get_stack_offset(std::string name) const {
 	}
 }
 
+bool IRContext::in_register(std::string name) const {
+	return registers.count(name) && !is_global(name);
+}
+
+unsigned IRContext::get_register(std::string name) const {
+	if(registers.count(name)) {
+		return registers.at(name);
+	} else {
+		throw compile_error((std::string)"IR: variable " + name + " was not allocated a register");
+	}
+}
+
 Type IRContext::get_type(std::string name) const {
 	if(stack.count(name)) {
 		return stack.at(name);
@@ -62,26 +76,57 @@ unsigned IRContext::get_return_struct_offset() const {
 	return return_struct_offset;
 }
 
+void IRContext::set_epilogue(std::string text) {
+	epilogue = text;
+}
+
+std::string IRContext::get_epilogue() const {
+	return epilogue;
+}
+
 /* ******************************************* */
 
+static std::string load_opcode(Type type) {
+	switch (type.bytes()) {
+	case 1:
+		return type.is_signed() ? "lb " : "lbu";
+	case 2:
+		return type.is_signed() ? "lh " : "lhu";
+	default:
+		return "lw";
+	}
+}
+
 void IRContext::load_variable(std::ostream &out, std::string source, unsigned reg_number) const {
+	if(in_register(source)) {
+		if(get_register(source) != reg_number) {
+			out << "    move    $" << reg_number << ", $" << get_register(source) << "\n";
+		}
+		return;
+	}
+	load_memory(out, source, reg_number);
+}
+
+void IRContext::load_register(std::ostream &out, std::string name) const {
+	// bring a register variable in from its stack home (used for incoming parameters)
+	load_memory(out, name, get_register(name));
+}
+
+unsigned IRContext::use_register(std::ostream &out, std::string source, unsigned scratch) const {
+	if(in_register(source)) {
+		return get_register(source);
+	}
+	load_memory(out, source, scratch);
+	return scratch;
+}
+
+void IRContext::load_memory(std::ostream &out, std::string source, unsigned reg_number) const {
 	Type src_type = get_type(source);
 	if(src_type.bytes() > 8) {
 		throw compile_error((std::string)"cannot load variable '" + source + "' of type '" + src_type.name() + "' into a register");
 	}
 	// how large is it?
-	std::string load_instr;
-	switch (src_type.bytes()) {
-	case 1:
-		load_instr = src_type.is_signed() ? "lb " : "lbu";
-		break;
-	case 2:
-		load_instr = src_type.is_signed() ? "lh " : "lhu";
-		break;
-	default:
-		load_instr = "lw";
-		break;
-	}
+	std::string load_instr = load_opcode(src_type);
 	// is it a labeled variable or local?
 	if(is_global(source)) {
 		out << "    lui     $2, %hi(" << source << ")\n";
@@ -104,6 +149,22 @@ void IRContext::store_variable(std::ostream &out, std::string destination, unsig
 	if(dst_type.bytes() > 8) {
 		throw compile_error((std::string)"cannot store a register into variable '" + destination + "' of type '" + dst_type.name() + "'");
 	}
+	// registers hold values exactly as a load of the truncated memory would return them
+	if(in_register(destination)) {
+		unsigned r = get_register(destination);
+		if(dst_type.is_integer() && dst_type.bytes() < 4) {
+			unsigned shift = 32 - 8 * dst_type.bytes();
+			if(dst_type.is_signed()) {
+				out << "    sll     $" << r << ", $" << reg_number << ", " << shift << "\n";
+				out << "    sra     $" << r << ", $" << r << ", " << shift << "\n";
+			} else {
+				out << "    andi    $" << r << ", $" << reg_number << ", " << (dst_type.bytes() == 1 ? "0xff" : "0xffff") << "\n";
+			}
+		} else if(r != reg_number) {
+			out << "    move    $" << r << ", $" << reg_number << "\n";
+		}
+		return;
+	}
 	// how large is it?
 	std::string store_instr;
 	switch (dst_type.bytes()) {
@@ -170,3 +231,47 @@ void IRContext::copy(std::ostream &out, std::string source, std::string destinat
 		out << "    sb      $8, " << (words * 4 + i) << "($3)\n";
 	}
 }
+
+int32_t IRContext::memory_address(std::ostream &out, std::string pointer, int32_t offset, bool direct, unsigned scratch, std::string& base) const {
+	std::stringstream reg;
+	reg << "$" << scratch;
+	if(direct && is_global(pointer)) {
+		out << "    lui     $" << scratch << ", %hi(" << pointer << ")\n";
+		out << "    addiu   $" << scratch << ", $" << scratch << ", %lo(" << pointer << ")\n";
+		base = reg.str();
+		return offset;
+	}
+	int64_t displacement = offset;
+	if(direct) {
+		displacement += get_stack_offset(pointer);
+		base = "$fp";
+	} else {
+		unsigned r = use_register(out, pointer, scratch);
+		std::stringstream name;
+		name << "$" << r;
+		base = name.str();
+	}
+	if(displacement < -32768 || displacement > 32767) {
+		out << "    li      $" << scratch << ", " << displacement << "\n";
+		out << "    addu    $" << scratch << ", $" << scratch << ", " << base << "\n";
+		base = reg.str();
+		return 0;
+	}
+	return (int32_t)displacement;
+}
+
+void IRContext::load_indirect(std::ostream &out, std::string destination, std::string base, int32_t offset) const {
+	Type dst_type = get_type(destination);
+	if(in_register(destination)) {
+		// a typed load already leaves the value in the form the register expects
+		out << "    " << load_opcode(dst_type) << "     $" << get_register(destination) << ", " << offset << "(" << base << ")\n";
+		out << "    nop\n";
+	} else {
+		if(offset != 0) {
+			out << "    addiu   $2, " << base << ", " << offset << "\n";
+		} else if(base != "$2") {
+			out << "    move    $2, " << base << "\n";
+		}
+		copy(out, "", destination, dst_type.bytes());
+	}
+}
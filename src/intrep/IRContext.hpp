@@ -1,6 +1,8 @@
 #ifndef IR_CONTEXT_H
 #define IR_CONTEXT_H
 
+#include <stdint.h>
+
 #include "VariableMap.hpp"
 
 class IRContext {
@@ -9,16 +11,23 @@ class IRContext {
 	FunctionStack stack;
 	// stack mappings
 	std::map<std::string, unsigned> stack_offsets;
+	// variables that live in a register instead of the stack
+	std::map<std::string, unsigned> registers;
 	// return label
 	std::string func_name;
 	// return value if struct or union
 	Type return_type;
 	unsigned return_struct_offset;
+	// frame teardown, for tail calls to run before jumping to their callee
+	std::string epilogue;
+
+	void load_memory(std::ostream &out, std::string source, unsigned reg_number) const;
 
 public:
 	IRContext(VariableMap const& globals,
 		FunctionStack const& stack,
 		std::map<std::string, unsigned> const& stack_offsets,
+		std::map<std::string, unsigned> const& registers,
 		std::string func_name,
 		Type return_type,
 		unsigned return_struct_offset);
@@ -26,18 +35,29 @@ public:
 	// variables
 	bool is_global(std::string name) const;
 	unsigned get_stack_offset(std::string name) const;
+	bool in_register(std::string name) const;
+	unsigned get_register(std::string name) const;
 	Type get_type(std::string name) const;
 	std::vector<Type> get_function_parameters(std::string name) const;
 	// returns
 	std::string get_return_label() const;
 	Type get_return_type() const;
 	unsigned get_return_struct_offset() const;
+	void set_epilogue(std::string text);
+	std::string get_epilogue() const;
 
 
 	// loading and storing
 	void load_variable(std::ostream &out, std::string source, unsigned reg_number) const;
 	void store_variable(std::ostream &out, std::string destination, unsigned reg_number) const;
+	void load_register(std::ostream &out, std::string name) const;
+	// register holding the variable: its own if it has one, otherwise scratch once loaded into it
+	unsigned use_register(std::ostream &out, std::string source, unsigned scratch) const;
 	void copy(std::ostream &out, std::string source, std::string destination, unsigned total_bytes) const;
+	// base register and displacement of *(pointer + offset), or of the variable pointer itself
+	// plus offset when direct; scratch is only set up when there is no simpler base
+	int32_t memory_address(std::ostream &out, std::string pointer, int32_t offset, bool direct, unsigned scratch, std::string& base) const;
+	void load_indirect(std::ostream &out, std::string destination, std::string base, int32_t offset) const;
 
 };
 
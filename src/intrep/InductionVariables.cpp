@@ -0,0 +1,277 @@
+#include "InductionVariables.hpp"
+
+#include "ControlFlowGraph.hpp"
+#include "Liveness.hpp"
+#include "UniqueNames.hpp"
+
+#include <algorithm>
+
+// *******************************************
+
+// a variable whose only write in the loop is "move i, t", with "t = i + step"
+// computed earlier in the same block
+struct Induction {
+	int32_t step;
+	Instruction* update;
+	Instruction* move;
+	unsigned block;
+};
+
+// a pointer kept equal to base + variable throughout the loop
+struct DerivedPointer {
+	std::string base;
+	std::string variable;
+	std::string pointer;
+	// the temporaries that used to hold base + variable
+	std::set<std::string> addresses;
+};
+
+bool constant_step(Instruction* instruction, FunctionStack const& stack, std::string variable, int32_t& step) {
+	if(!dynamic_cast<IncrementInstruction*>(instruction) && !dynamic_cast<AddInstruction*>(instruction)
+		&& !dynamic_cast<SubInstruction*>(instruction)) return false;
+	std::vector<std::string> sources = instruction->get_sources();
+	if(sources.size() != 1 || sources.at(0) != variable) return false;
+	ConstantValues known;
+	int32_t next;
+	known[variable] = 0;
+	if(!instruction->evaluate(known, stack, step)) return false;
+	known[variable] = 1;
+	return instruction->evaluate(known, stack, next) && next == step + 1 && step != 0;
+}
+
+static bool is_word_integer(FunctionStack const& stack, std::string name) {
+	return stack.count(name) && stack.at(name).is_integer() && stack.at(name).bytes() == 4;
+}
+
+static std::string find_pointer(std::vector<DerivedPointer> const& derived, std::string base, std::string variable) {
+	for(std::vector<DerivedPointer>::const_iterator itr = derived.begin(); itr != derived.end(); ++itr) {
+		if(itr->base == base && itr->variable == variable) return itr->pointer;
+	}
+	return "";
+}
+
+// *******************************************
+
+/*
+ * Replace the exit test on an induction variable by the same test on a pointer walking
+ * with it, so the variable can go.  The pointer is only compared against base + limit
+ * when every iteration accesses memory through it: the loop then steps over the whole
+ * array up to the limit, and base + limit cannot wrap around.  The loop is guarded in the
+ * preheader by the original test, so a loop that never runs never computes that address.
+ */
+static bool replace_exit_test(ControlFlowGraph& cfg, NaturalLoop const& loop, FunctionStack& stack,
+	std::string variable, Induction const& induction, DerivedPointer const& derived,
+	std::set<std::string> const& address_taken, std::set<std::string> const& read, IRVector& preheader) {
+	BasicBlock& header = cfg.blocks.at(loop.header);
+	GotoIfInstruction* exit = header.instructions.empty() ? NULL : dynamic_cast<GotoIfInstruction*>(header.instructions.back());
+	if(!exit || loop.blocks.count(cfg.find_block(exit->get_label()))) return false;
+	std::vector<std::string> sources = exit->get_sources();
+	if(sources.at(0) != variable || !stack.at(variable).is_signed()) return false;
+	char relation = exit->get_relation();
+	bool upwards = induction.step > 0 && (relation == 'g' || relation == '>');
+	bool downwards = induction.step < 0 && (relation == 'l' || relation == '<');
+	if(!upwards && !downwards) return false;
+
+	// the header test is the only way out
+	unsigned exits = 0;
+	for(std::set<unsigned>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b) {
+		std::vector<unsigned> const& succ = cfg.blocks.at(*b).successors;
+		for(std::vector<unsigned>::const_iterator s = succ.begin(); s != succ.end(); ++s) {
+			if(!loop.blocks.count(*s)) exits++;
+		}
+	}
+	if(exits != 1) return false;
+
+	// a fixed signed limit
+	std::string limit = sources.size() > 1 ? sources.at(1) : "";
+	ImmediateOperand const& immediate = exit->get_immediate();
+	if(limit != "" && (!stack.count(limit) || !stack.at(limit).is_signed() || address_taken.count(limit))) return false;
+	if(immediate.bound && !immediate.type.is_signed()) return false;
+
+	// what still reads the variable, or its next value, apart from the test and the step
+	std::string next = induction.update->get_destination();
+	std::vector<Instruction*> copies;
+	bool accessed = false;
+	for(std::set<unsigned>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b) {
+		bool every_iteration = true;
+		for(std::vector<unsigned>::const_iterator l = loop.latches.begin(); l != loop.latches.end(); ++l) {
+			if(!cfg.dominates(*b, *l)) every_iteration = false;
+		}
+		IRVector const& instructions = cfg.blocks.at(*b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			Instruction* instruction = *itr;
+			if(limit != "" && instruction->get_destination() == limit) return false;
+			DereferenceInstruction* load = dynamic_cast<DereferenceInstruction*>(instruction);
+			AssignInstruction* store = dynamic_cast<AssignInstruction*>(instruction);
+			std::string pointer = load ? load->get_pointer() : store ? store->get_pointer() : "";
+			if(every_iteration && derived.addresses.count(pointer)) accessed = true;
+
+			if(instruction == exit || instruction == induction.update || instruction == induction.move) continue;
+			sources = instruction->get_sources();
+			bool reads = std::find(sources.begin(), sources.end(), variable) != sources.end()
+				|| std::find(sources.begin(), sources.end(), next) != sources.end();
+			if(!reads) continue;
+			// postfix copies nothing reads
+			std::string d = instruction->get_destination();
+			if(!dynamic_cast<MoveInstruction*>(instruction) || !stack.count(d) || address_taken.count(d) || read.count(d)) return false;
+			copies.push_back(instruction);
+		}
+	}
+	if(!accessed) return false;
+	int after = cfg.find_block(exit->get_label());
+	Liveness liveness(cfg, stack);
+	if(liveness.live_in.at(after).count(variable)) return false;
+
+	std::string end = derived.base;
+	if(limit != "" || immediate.bound) {
+		if(limit == "") {
+			limit = unique("int");
+			stack[limit] = Type("int", 0);
+			preheader.push_back(new ConstantInstruction(limit, stack.at(limit), immediate.value));
+		}
+		end = unique("induction_limit");
+		stack[end] = stack.at(derived.pointer);
+		preheader.push_back(new AddInstruction(end, derived.base, limit));
+	}
+	preheader.push_back(new GotoIfInstruction(*exit));
+	header.instructions.back() = new GotoIfInstruction(exit->get_label(), derived.pointer, end, relation);
+	delete exit;
+
+	copies.push_back(induction.update);
+	copies.push_back(induction.move);
+	for(std::vector<Instruction*>::const_iterator c = copies.begin(); c != copies.end(); ++c) {
+		for(std::set<unsigned>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b) {
+			IRVector& instructions = cfg.blocks.at(*b).instructions;
+			IRVector::iterator found = std::find(instructions.begin(), instructions.end(), *c);
+			if(found != instructions.end()) instructions.erase(found);
+		}
+		delete *c;
+	}
+	return true;
+}
+
+static bool reduce_loop(IRVector& code, FunctionStack& stack, ControlFlowGraph& cfg, NaturalLoop const& loop) {
+	if(!cfg.has_preheader_slot(loop)) return false;
+
+	std::set<std::string> address_taken = address_taken_variables(code);
+	std::map<std::string, unsigned> definitions;
+	std::set<std::string> read;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		definitions[(*itr)->get_destination()]++;
+		std::vector<std::string> sources = (*itr)->get_sources();
+		read.insert(sources.begin(), sources.end());
+	}
+	std::map<std::string, std::vector<Instruction*> > loop_definitions;
+	std::map<Instruction*, std::pair<unsigned, unsigned> > position;
+	for(std::set<unsigned>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b) {
+		IRVector const& instructions = cfg.blocks.at(*b).instructions;
+		for(unsigned i = 0; i < instructions.size(); i++) {
+			loop_definitions[instructions.at(i)->get_destination()].push_back(instructions.at(i));
+			position[instructions.at(i)] = std::make_pair(*b, i);
+		}
+	}
+
+	std::map<std::string, Induction> inductions;
+	for(std::map<std::string, std::vector<Instruction*> >::const_iterator itr = loop_definitions.begin(); itr != loop_definitions.end(); ++itr) {
+		std::string v = itr->first;
+		MoveInstruction* move = dynamic_cast<MoveInstruction*>(itr->second.front());
+		if(itr->second.size() != 1 || !move || !is_word_integer(stack, v) || address_taken.count(v)) continue;
+		std::string t = move->get_sources().at(0);
+		if(definitions[t] != 1 || !loop_definitions.count(t)) continue;
+		Induction induction;
+		induction.update = loop_definitions.at(t).front();
+		induction.move = move;
+		induction.block = position.at(move).first;
+		if(!is_word_integer(stack, t) || !constant_step(induction.update, stack, v, induction.step)) continue;
+		// a fresh step before every write, so each write adds exactly the step
+		if(position.at(induction.update).first != induction.block || position.at(induction.update).second > position.at(move).second) continue;
+		inductions[v] = induction;
+	}
+
+	// "add a, base, i" with the base fixed in the loop becomes "move a, p"
+	IRVector preheader;
+	std::vector<DerivedPointer> derived;
+	for(std::set<unsigned>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b) {
+		IRVector& instructions = cfg.blocks.at(*b).instructions;
+		for(unsigned i = 0; i < instructions.size(); i++) {
+			AddInstruction* add = dynamic_cast<AddInstruction*>(instructions.at(i));
+			std::vector<std::string> sources = add ? add->get_sources() : std::vector<std::string>();
+			if(sources.size() != 2) continue;
+			std::string base = inductions.count(sources.at(1)) ? sources.at(0) : sources.at(1);
+			std::string v = base == sources.at(0) ? sources.at(1) : sources.at(0);
+			if(!inductions.count(v) || !stack.count(base) || !stack.at(base).is_pointer()) continue;
+			if(!stack.arrays.count(base) && (address_taken.count(base) || loop_definitions.count(base))) continue;
+
+			std::string pointer = find_pointer(derived, base, v);
+			if(pointer == "") {
+				DerivedPointer d;
+				d.base = base;
+				d.variable = v;
+				d.pointer = pointer = unique("induction");
+				stack[pointer] = stack.at(base);
+				preheader.push_back(new AddInstruction(pointer, base, v));
+				derived.push_back(d);
+			}
+			for(std::vector<DerivedPointer>::iterator d = derived.begin(); d != derived.end(); ++d) {
+				if(d->pointer == pointer) d->addresses.insert(add->get_destination());
+			}
+			instructions.at(i) = new MoveInstruction(add->get_destination(), pointer);
+			delete add;
+		}
+	}
+	if(derived.empty()) return false;
+
+	// each pointer steps right after its variable
+	for(std::vector<DerivedPointer>::const_iterator d = derived.begin(); d != derived.end(); ++d) {
+		Induction const& induction = inductions.at(d->variable);
+		Instruction* step;
+		if(induction.step == 1 || induction.step == -1) {
+			step = new IncrementInstruction(d->pointer, d->pointer, induction.step < 0);
+		} else {
+			std::string c = unique("int");
+			stack[c] = Type("int", 0);
+			preheader.push_back(new ConstantInstruction(c, stack.at(c), induction.step));
+			step = new AddInstruction(d->pointer, d->pointer, c);
+			step->bind_immediate(c, induction.step, stack);
+		}
+		IRVector& instructions = cfg.blocks.at(induction.block).instructions;
+		instructions.insert(std::find(instructions.begin(), instructions.end(), induction.move) + 1, step);
+	}
+
+	// the first variable only the exit test still needs is dropped
+	for(std::vector<DerivedPointer>::const_iterator d = derived.begin(); d != derived.end(); ++d) {
+		if(replace_exit_test(cfg, loop, stack, d->variable, inductions.at(d->variable), *d, address_taken, read, preheader)) break;
+	}
+
+	IRVector result;
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		if(b == loop.header) {
+			result.push_back(new LabelInstruction(unique("preheader")));
+			result.insert(result.end(), preheader.begin(), preheader.end());
+		}
+		result.insert(result.end(), cfg.blocks.at(b).instructions.begin(), cfg.blocks.at(b).instructions.end());
+	}
+	code = result;
+	return true;
+}
+
+// *******************************************
+
+static bool deeper(NaturalLoop const& a, NaturalLoop const& b) {
+	return a.depth > b.depth;
+}
+
+void reduce_induction_variables(IRVector& code, FunctionStack& stack) {
+	// innermost first: the start address an inner loop computes before it runs is
+	// itself an address an outer loop can step
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		ControlFlowGraph cfg(code);
+		std::vector<NaturalLoop> loops = cfg.loops;
+		std::stable_sort(loops.begin(), loops.end(), deeper);
+		for(std::vector<NaturalLoop>::const_iterator l = loops.begin(); l != loops.end() && !changed; ++l) {
+			changed = reduce_loop(code, stack, cfg, *l);
+		}
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef IR_INDUCTION_VARIABLES_H
+#define IR_INDUCTION_VARIABLES_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+/*
+ * Strength reduction of array addresses in loops: "a + i" with a fixed in the loop
+ * and i stepping by a constant becomes a pointer set to a + i before the loop and
+ * stepped alongside i.  When nothing but the exit test still reads i afterwards,
+ * the test compares the pointer against a + limit instead and i goes away.
+ */
+void reduce_induction_variables(IRVector& code, FunctionStack& stack);
+
+// the constant an increment, or an add or sub of an immediate, adds to variable, its only source
+bool constant_step(Instruction* instruction, FunctionStack const& stack, std::string variable, int32_t& step);
+
+#endif
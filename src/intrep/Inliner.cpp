@@ -0,0 +1,57 @@
+#include "Inliner.hpp"
+
+#include "UniqueNames.hpp"
+
+// *******************************************
+
+unsigned inline_cost(IRVector const& body) {
+	unsigned cost = 0;
+	for(IRVector::const_iterator itr = body.begin(); itr != body.end(); ++itr) {
+		if(!dynamic_cast<LabelInstruction*>(*itr)) cost++;
+	}
+	return cost;
+}
+
+bool is_inlinable(IRVector const& body) {
+	for(IRVector::const_iterator itr = body.begin(); itr != body.end(); ++itr) {
+		LabelInstruction* label = dynamic_cast<LabelInstruction*>(*itr);
+		if(label && label->get_name().compare(0, 4, "lbl_") == 0) return false;
+	}
+	return true;
+}
+
+// *******************************************
+
+unsigned splice_call(IRVector& code, unsigned index, IRVector const& body,
+	std::vector<std::string> const& parameters, FunctionStack const& stack) {
+	FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(code.at(index));
+	std::string result = call->get_destination();
+	std::vector<std::string> arguments = call->get_arguments();
+	// void calls still name a result, but there is nothing to move into it
+	bool has_result = result != "" && stack.count(result)
+		&& (stack.at(result).is_pointer() || stack.at(result).builtin_type != Type::Void);
+	std::string end = unique("inline_" + call->get_function_name()) + "_end";
+
+	IRVector spliced;
+	for(unsigned i = 0; i < parameters.size(); i++) {
+		spliced.push_back(new MoveInstruction(parameters.at(i), arguments.at(i)));
+	}
+	for(IRVector::const_iterator itr = body.begin(); itr != body.end(); ++itr) {
+		if(ReturnInstruction* r = dynamic_cast<ReturnInstruction*>(*itr)) {
+			std::vector<std::string> value = r->get_sources();
+			if(has_result && !value.empty()) {
+				spliced.push_back(new MoveInstruction(result, value.at(0)));
+			}
+			spliced.push_back(new GotoInstruction(end));
+			delete r;
+			continue;
+		}
+		spliced.push_back(*itr);
+	}
+	spliced.push_back(new LabelInstruction(end));
+
+	delete call;
+	code.erase(code.begin() + index);
+	code.insert(code.begin() + index, spliced.begin(), spliced.end());
+	return index + spliced.size();
+}
@@ -0,0 +1,23 @@
+#ifndef IR_INLINER_H
+#define IR_INLINER_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// instructions a lowered body adds to a caller once copied into it, labels are free
+unsigned inline_cost(IRVector const& body);
+
+// every name in a freshly lowered body comes from unique(), except the labels of
+// user gotos (lbl_...), which are global and can only exist once per program
+bool is_inlinable(IRVector const& body);
+
+/*
+ * Replace the call at code[index] with a freshly lowered callee body: the arguments
+ * are moved into the callee's parameters, and every return becomes a move of its
+ * value into the call's result and a jump past the body.  Takes ownership of the
+ * body's instructions, and returns the index just after what was spliced in.
+ */
+unsigned splice_call(IRVector& code, unsigned index, IRVector const& body,
+	std::vector<std::string> const& parameters, FunctionStack const& stack);
+
+#endif
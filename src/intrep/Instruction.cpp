@@ -2,6 +2,7 @@
 #include "Conversions.hpp"
 #include "UniqueNames.hpp"
 
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
@@ -9,10 +10,304 @@ void Instruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream&
 	out << "    undefined\n";
 }
 
+std::string Instruction::get_destination() const {
+	return "";
+}
+
+std::vector<std::string> Instruction::get_sources() const {
+	return std::vector<std::string>();
+}
+
+bool Instruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	return false;
+}
+
+void Instruction::rename(std::map<std::string, std::string> const& names) {}
+
+bool Instruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	return false;
+}
+
+std::string Instruction::get_addressed_variable() const {
+	return "";
+}
+
+bool Instruction::address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const {
+	return false;
+}
+
+ImmediateOperand::ImmediateOperand() : bound(false), value(0) {}
+
+static void rename_variable(std::map<std::string, std::string> const& names, std::string& name) {
+	std::map<std::string, std::string>::const_iterator itr = names.find(name);
+	if(itr != names.end()) name = itr->second;
+}
+
+// type of an integer variable that constants can be worked out for
+static bool integer_variable(FunctionStack const& stack, std::string name, Type& type) {
+	if(!stack.count(name)) return false;
+	type = stack.at(name);
+	return type.is_integer() && type.bytes() <= 4;
+}
+
+static bool known_value(ConstantValues const& known, std::string name, int32_t& value) {
+	if(!known.count(name)) return false;
+	value = known.at(name);
+	return true;
+}
+
+// value of an operand that may have been replaced by an immediate
+static bool operand_value(ConstantValues const& known, std::string source, ImmediateOperand const& immediate, int32_t& value) {
+	if(immediate.bound) {
+		value = immediate.value;
+		return true;
+	}
+	return known_value(known, source, value);
+}
+
+static std::string operand_name(std::string source, ImmediateOperand const& immediate) {
+	if(!immediate.bound) return source;
+	std::stringstream ss;
+	ss << immediate.value;
+	return ss.str();
+}
+
+static bool fits_signed16(int64_t value) {
+	return value >= -32768 && value <= 32767;
+}
+
+static bool fits_unsigned16(int64_t value) {
+	return value >= 0 && value <= 65535;
+}
+
+// word-sized or smaller integer or pointer, as slt/slti compare them
+static bool comparable_variable(FunctionStack const& stack, std::string name, Type& type) {
+	if(!stack.count(name)) return false;
+	type = stack.at(name);
+	return (type.is_integer() || type.is_pointer()) && type.bytes() <= 4;
+}
+
+// the same relation with its operands swapped
+static char mirror_relation(char relation) {
+	switch (relation) {
+		case '<': return '>';
+		case '>': return '<';
+		case 'l': return 'g';
+		case 'g': return 'l';
+		default: return relation;
+	}
+}
+
+// "x relation value" as slti/sltiu against bound: < and >= compare with value itself,
+// > and <= with value + 1; false if bound does not fit the 16 bit immediate
+static bool compare_bound(char relation, int32_t value, bool is_signed, int32_t& bound) {
+	if(relation == '<' || relation == 'g') {
+		bound = value;
+	} else if(relation == '>' || relation == 'l') {
+		if(is_signed ? value == 0x7fffffff : (uint32_t)value == 0xffffffff) return false;
+		bound = (int32_t)((uint32_t)value + 1);
+	} else {
+		return false;
+	}
+	return fits_signed16(bound);
+}
+
+// a relation of EqualityInstruction, with the same choice between slt and sltu as PrintMIPS
+static bool compare_values(char relation, int32_t a, int32_t b, bool is_signed) {
+	bool less = is_signed ? a < b : (uint32_t)a < (uint32_t)b;
+	bool greater = is_signed ? a > b : (uint32_t)a > (uint32_t)b;
+	switch (relation) {
+		case '=': return a == b;
+		case '!': return a != b;
+		case '<': return less;
+		case '>': return greater;
+		case 'l': return !greater;
+		case 'g': return !less;
+		default:
+			throw compile_error("unsupported type of relational operator");
+	}
+}
+
+static int log2_exact(uint32_t value) {
+	if(value == 0 || (value & (value - 1)) != 0) return -1;
+	int k = 0;
+	while(value >>= 1) k++;
+	return k;
+}
+
+// dst = src * factor with at most three shifts and adds (plus a negation), $11 as scratch;
+// false if the factor needs a real multiplication.  The low word of a product is the
+// same for signed and unsigned operands, so this serves both.
+static bool multiply_by_constant(std::ostream& out, unsigned dst, unsigned src, int32_t factor) {
+	uint32_t m = factor < 0 ? 0u - (uint32_t)factor : (uint32_t)factor;
+	int k = log2_exact(m);
+	if(factor == 0) {
+		out << "    move    $" << dst << ", $0\n";
+		return true;
+	} else if(k == 0) {
+		if(dst != src || factor < 0) out << "    move    $" << dst << ", $" << src << "\n";
+	} else if(k > 0) {
+		out << "    sll     $" << dst << ", $" << src << ", " << k << "\n";
+	} else if((k = log2_exact(m - 1)) > 0) {
+		out << "    sll     $11, $" << src << ", " << k << "\n";
+		out << "    addu    $" << dst << ", $11, $" << src << "\n";
+	} else if((k = log2_exact(m + 1)) > 0) {
+		out << "    sll     $11, $" << src << ", " << k << "\n";
+		out << "    subu    $" << dst << ", $11, $" << src << "\n";
+	} else {
+		// two set bits: 2^high + 2^low
+		int low = log2_exact(m & (0u - m));
+		int high = log2_exact(m - (m & (0u - m)));
+		if(high < 0) return false;
+		out << "    sll     $11, $" << src << ", " << high << "\n";
+		out << "    sll     $" << dst << ", $" << src << ", " << low << "\n";
+		out << "    addu    $" << dst << ", $" << dst << ", $11\n";
+	}
+	if(factor < 0) {
+		out << "    subu    $" << dst << ", $0, $" << dst << "\n";
+	}
+	return true;
+}
+
+// reciprocal of a signed divisor 2 <= |d| < 2^31 that is not a power of two,
+// as in Hacker's Delight 10-1: q = (mulhi(n, magic) [+-n]) >> shift, rounded toward zero
+static void signed_magic(int32_t d, int32_t& magic, unsigned& shift) {
+	const uint32_t two31 = 0x80000000u;
+	uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+	uint32_t t = two31 + ((uint32_t)d >> 31);
+	uint32_t anc = t - 1 - t % ad;
+	unsigned p = 31;
+	uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+	uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+	uint32_t delta;
+	do {
+		p++;
+		q1 *= 2;
+		r1 *= 2;
+		if(r1 >= anc) {
+			q1++;
+			r1 -= anc;
+		}
+		q2 *= 2;
+		r2 *= 2;
+		if(r2 >= ad) {
+			q2++;
+			r2 -= ad;
+		}
+		delta = ad - r2;
+	} while(q1 < delta || (q1 == delta && r1 == 0));
+	magic = (int32_t)(q2 + 1);
+	if(d < 0) magic = -magic;
+	shift = p - 32;
+}
+
+// reciprocal of an unsigned divisor 2 < d < 2^31 that is not a power of two:
+// q = mulhi(n, magic) >> shift, or with add set the 33-bit reciprocal
+// q = (((n - t) >> 1) + t) >> shift, t = mulhi(n, magic)
+static void unsigned_magic(uint32_t d, uint32_t& magic, unsigned& shift, bool& add) {
+	unsigned l = 0;
+	while(((uint64_t)1 << l) < d) l++;
+	for(unsigned s = 0; s <= l; s++) {
+		uint64_t power = (uint64_t)1 << (32 + s);
+		uint64_t m = (power + d - 1) / d;
+		// the rounding error m * d - 2^(32+s) must stay below 2^s for every 32 bit n
+		if(m <= 0xffffffffu && m * d - power <= ((uint64_t)1 << s)) {
+			magic = (uint32_t)m;
+			shift = s;
+			add = false;
+			return;
+		}
+	}
+	magic = (uint32_t)((((uint64_t)1 << 32) * (((uint64_t)1 << l) - d)) / d + 1);
+	shift = l - 1;
+	add = true;
+}
+
+// $q = $n / d for a constant d != 0, without a div; $9, $11, $14 as scratch ($q, $n not among them)
+static void divide_by_constant(std::ostream& out, unsigned q, unsigned n, int32_t d, bool is_signed) {
+	if(!is_signed) {
+		uint32_t ud = (uint32_t)d;
+		int k = log2_exact(ud);
+		if(k >= 0) {
+			out << "    srl     $" << q << ", $" << n << ", " << k << "\n";
+		} else if(ud > 0x80000000u) {
+			// the quotient is 0 or 1
+			out << "    li      $9, " << d << "\n";
+			out << "    sltu    $" << q << ", $" << n << ", $9\n";
+			out << "    xori    $" << q << ", $" << q << ", 1\n";
+		} else {
+			uint32_t magic;
+			unsigned shift;
+			bool add;
+			unsigned_magic(ud, magic, shift, add);
+			out << "    li      $14, " << (int32_t)magic << "\n";
+			out << "    multu   $" << n << ", $14\n";
+			out << "    nop\n";
+			if(add) {
+				out << "    mfhi    $9\n";
+				out << "    subu    $" << q << ", $" << n << ", $9\n";
+				out << "    srl     $" << q << ", $" << q << ", 1\n";
+				out << "    addu    $" << q << ", $" << q << ", $9\n";
+			} else {
+				out << "    mfhi    $" << q << "\n";
+			}
+			if(shift > 0) out << "    srl     $" << q << ", $" << q << ", " << shift << "\n";
+		}
+		return;
+	}
+
+	uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+	int k = log2_exact(ad);
+	if(k == 0) {
+		out << "    move    $" << q << ", $" << n << "\n";
+	} else if(k > 0) {
+		// a negative dividend is biased by 2^k - 1 so the shift rounds toward zero
+		if(k > 1) {
+			out << "    sra     $9, $" << n << ", 31\n";
+			out << "    srl     $9, $9, " << 32 - k << "\n";
+		} else {
+			out << "    srl     $9, $" << n << ", 31\n";
+		}
+		out << "    addu    $9, $" << n << ", $9\n";
+		out << "    sra     $" << q << ", $9, " << k << "\n";
+	} else {
+		int32_t magic;
+		unsigned shift;
+		signed_magic(d, magic, shift);
+		out << "    li      $14, " << magic << "\n";
+		out << "    mult    $" << n << ", $14\n";
+		out << "    nop\n";
+		out << "    mfhi    $" << q << "\n";
+		if(d > 0 && magic < 0) out << "    addu    $" << q << ", $" << q << ", $" << n << "\n";
+		if(d < 0 && magic > 0) out << "    subu    $" << q << ", $" << q << ", $" << n << "\n";
+		if(shift > 0) out << "    sra     $" << q << ", $" << q << ", " << shift << "\n";
+		// add one to a negative quotient
+		out << "    srl     $9, $" << q << ", 31\n";
+		out << "    addu    $" << q << ", $" << q << ", $9\n";
+		return;
+	}
+	if(d < 0) {
+		out << "    subu    $" << q << ", $0, $" << q << "\n";
+	}
+}
+
+// turn an element count in reg into a byte offset
+static void scale_offset(std::ostream& out, unsigned reg, unsigned size) {
+	if(size == 1) return;
+	if(!multiply_by_constant(out, reg, reg, size)) {
+		out << "    li      $11, " << size << "\n";
+		out << "    mul     $" << reg << ", $" << reg << ", $11\n";
+	}
+}
+
 // *******************************************
 
 LabelInstruction::LabelInstruction(std::string name) : label_name(name) {}
 
+Instruction* LabelInstruction::clone() const {
+	return new LabelInstruction(*this);
+}
+
 void LabelInstruction::Debug(std::ostream &dst) const {
 	dst << "  " << label_name << ":" << std::endl;
 }
@@ -21,10 +316,18 @@ void LabelInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ost
 	out << "  " << label_name << ":\n";
 }
 
+std::string LabelInstruction::get_name() const {
+	return label_name;
+}
+
 // *******************************************
 
 GotoInstruction::GotoInstruction(std::string name) : label_name(name) {}
 
+Instruction* GotoInstruction::clone() const {
+	return new GotoInstruction(*this);
+}
+
 void GotoInstruction::Debug(std::ostream &dst) const {
 	dst << "    goto " << label_name << std::endl;
 }
@@ -34,28 +337,345 @@ void GotoInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostr
 	out << "    nop\n";
 }
 
+std::string GotoInstruction::get_label() const {
+	return label_name;
+}
+
 // *******************************************
 
-GotoIfEqualInstruction::GotoIfEqualInstruction(std::string name, std::string variable, int32_t value) : label_name(name), variable(variable), value(value) {}
+GotoIfInstruction::GotoIfInstruction(std::string name, std::string source1, std::string source2, char relation)
+: label_name(name), source1(source1), source2(source2), relation(relation) {}
 
-void GotoIfEqualInstruction::Debug(std::ostream &dst) const {
-	dst << "    beq " << variable << ", " << value << ", " << label_name << std::endl;
+Instruction* GotoIfInstruction::clone() const {
+	return new GotoIfInstruction(*this);
 }
 
-void GotoIfEqualInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
-	std::string skip_label = unique("$L");
-	context.load_variable(out, variable, 8);
-	convert_type(out, 8, context.get_type(variable), 10, Type("int", 0));
-	if(value == 0) {
-		out << "    bne     $10, $0, " << skip_label << "\n";
+void GotoIfInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
+void GotoIfInstruction::Debug(std::ostream &dst) const {
+	std::string mnemonic;
+	switch (relation) {
+		case '=': mnemonic = "beq"; break;
+		case '!': mnemonic = "bne"; break;
+		case '<': mnemonic = "blt"; break;
+		case '>': mnemonic = "bgt"; break;
+		case 'l': mnemonic = "ble"; break;
+		case 'g': mnemonic = "bge"; break;
+		default:
+			throw compile_error("unsupported type of relational operator in GotoIfInstruction");
+	}
+	if(source2 == "" && !immediate.bound) {
+		dst << "    " << mnemonic << "z " << source1 << ", " << label_name << std::endl;
 	} else {
-		out << "    li      $11, " << value << "\n";
-		out << "    bne     $10, $11, " << skip_label << "\n";
+		dst << "    " << mnemonic << " " << source1 << ", " << operand_name(source2, immediate) << ", " << label_name << std::endl;
+	}
+}
+
+void GotoIfInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	Type l = context.get_type(source1);
+	Type r = immediate.bound ? immediate.type : source2 == "" ? Type("int", 0) : context.get_type(source2);
+	unsigned a = context.use_register(out, source1, 8);
+
+	if(l.is_float() && source2 == "" && !immediate.bound) {
+		// +0.0 and -0.0 are the only zeroes: everything but the sign bit is clear
+		if(relation != '=' && relation != '!') {
+			throw compile_error("unsupported comparison of a floating point value with zero");
+		}
+		out << "    sll     $10, $" << a << ", 1\n";
+		if(l.bytes() == 8) {
+			out << "    or      $10, $10, $" << (a + 1) << "\n";
+		}
+		out << "    " << (relation == '=' ? "beq " : "bne ") << "    $10, $0, " << label_name << "\n";
+		out << "    nop\n";
+		return;
+	}
+	if(!(l.is_integer() || l.is_pointer()) || !(r.is_integer() || r.is_pointer())) {
+		throw compile_error((std::string)"conditional jump not defined between types '" + l.name() + "' and '" + r.name() + "'");
+	}
+
+	bool is_signed = l.is_signed() && r.is_signed();
+	if(immediate.bound) {
+		// slti/sltiu against the constant, or a register holding it for == and !=
+		int32_t bound;
+		if(compare_bound(relation, immediate.value, is_signed, bound)) {
+			out << "    " << (is_signed ? "slti " : "sltiu") << "   $25, $" << a << ", " << bound << "\n";
+			bool holds_when_less = (relation == '<' || relation == 'l');
+			out << "    " << (holds_when_less ? "bne " : "beq ") << "    $25, $0, " << label_name << "\n";
+		} else if(relation == '=' || relation == '!') {
+			out << "    li      $9, " << immediate.value << "\n";
+			out << "    " << (relation == '=' ? "beq " : "bne ") << "    $" << a << ", $9, " << label_name << "\n";
+		} else {
+			throw compile_error("immediate operand out of range in GotoIfInstruction");
+		}
+		out << "    nop\n";
+		return;
+	}
+	if(source2 == "") {
+		// compare with $0 directly
+		switch (relation) {
+			case '=': out << "    beq     $" << a << ", $0, " << label_name << "\n"; break;
+			case '!': out << "    bne     $" << a << ", $0, " << label_name << "\n"; break;
+			case '<':
+				if(!is_signed) return;
+				out << "    bltz    $" << a << ", " << label_name << "\n";
+				break;
+			case '>':
+				out << "    " << (is_signed ? "bgtz" : "bne ") << "    $" << a << (is_signed ? "" : ", $0") << ", " << label_name << "\n";
+				break;
+			case 'l':
+				out << "    " << (is_signed ? "blez" : "beq ") << "    $" << a << (is_signed ? "" : ", $0") << ", " << label_name << "\n";
+				break;
+			case 'g':
+				if(is_signed) {
+					out << "    bgez    $" << a << ", " << label_name << "\n";
+				} else {
+					out << "    j       " << label_name << "\n";
+				}
+				break;
+			default:
+				throw compile_error("unsupported type of relational operator in GotoIfInstruction");
+		}
+		out << "    nop\n";
+		return;
+	}
+
+	unsigned b = context.use_register(out, source2, 9);
+	std::string slt = is_signed ? "slt " : "sltu";
+	switch (relation) {
+		case '=':
+			out << "    beq     $" << a << ", $" << b << ", " << label_name << "\n";
+			break;
+		case '!':
+			out << "    bne     $" << a << ", $" << b << ", " << label_name << "\n";
+			break;
+		case '<':
+			out << "    " << slt << "    $25, $" << a << ", $" << b << "\n";
+			out << "    bne     $25, $0, " << label_name << "\n";
+			break;
+		case '>':
+			out << "    " << slt << "    $25, $" << b << ", $" << a << "\n";
+			out << "    bne     $25, $0, " << label_name << "\n";
+			break;
+		case 'l':
+			out << "    " << slt << "    $25, $" << b << ", $" << a << "\n";
+			out << "    beq     $25, $0, " << label_name << "\n";
+			break;
+		case 'g':
+			out << "    " << slt << "    $25, $" << a << ", $" << b << "\n";
+			out << "    beq     $25, $0, " << label_name << "\n";
+			break;
+		default:
+			throw compile_error("unsupported type of relational operator in GotoIfInstruction");
 	}
 	out << "    nop\n";
-	out << "    j       " << label_name << "\n";
+}
+
+std::vector<std::string> GotoIfInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool GotoIfInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t, other;
+	if(immediate.bound || source2 == "" || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(source == source1) {
+		std::swap(source1, source2);
+		relation = mirror_relation(relation);
+	}
+	if(!comparable_variable(stack, source1, other)) return false;
+	bool is_signed = other.is_signed() && t.is_signed();
+	int32_t bound;
+	if(value == 0 && is_signed) {
+		// beqz, bltz and friends
+		source2 = "";
+		return true;
+	}
+	if(!compare_bound(relation, value, is_signed, bound) && relation != '=' && relation != '!') return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
+std::string GotoIfInstruction::get_label() const {
+	return label_name;
+}
+
+char GotoIfInstruction::get_relation() const {
+	return relation;
+}
+
+ImmediateOperand const& GotoIfInstruction::get_immediate() const {
+	return immediate;
+}
+
+bool GotoIfInstruction::evaluate_condition(ConstantValues const& known, FunctionStack const& stack, bool& taken) const {
+	Type l, r("int", 0);
+	int32_t a, b = 0;
+	if(!integer_variable(stack, source1, l) || !known_value(known, source1, a)) return false;
+	if(immediate.bound) {
+		r = immediate.type;
+		b = immediate.value;
+	} else if(source2 != "" && (!integer_variable(stack, source2, r) || !known_value(known, source2, b))) {
+		return false;
+	}
+	taken = compare_values(relation, a, b, l.is_signed() && r.is_signed());
+	return true;
+}
+
+// *******************************************
+
+// a table pays off once at least a third of its entries are real cases
+#define JUMP_TABLE_MIN_CASES 4
+#define JUMP_TABLE_MAX_ENTRIES 1024
+
+SwitchInstruction::SwitchInstruction(std::string variable, std::map<int32_t, std::string> const& cases, std::string default_label)
+: variable(variable), cases(cases), default_label(default_label), jump_table(false) {
+	if(cases.size() >= JUMP_TABLE_MIN_CASES) {
+		int64_t range = (int64_t)cases.rbegin()->first - cases.begin()->first + 1;
+		jump_table = range <= JUMP_TABLE_MAX_ENTRIES && range <= 3 * (int64_t)cases.size();
+	}
+}
+
+Instruction* SwitchInstruction::clone() const {
+	return new SwitchInstruction(*this);
+}
+
+void SwitchInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, variable);
+}
+
+void SwitchInstruction::Debug(std::ostream &dst) const {
+	dst << "    switch " << variable << ", ";
+	if(jump_table) {
+		dst << "jump table " << cases.begin()->first << ".." << cases.rbegin()->first;
+	} else {
+		dst << "binary search";
+	}
+	dst << ", default " << default_label << std::endl;
+	for(std::map<int32_t, std::string>::const_iterator itr = cases.begin(); itr != cases.end(); ++itr) {
+		dst << "      case " << itr->first << ", " << itr->second << std::endl;
+	}
+}
+
+typedef std::vector<std::pair<int32_t, std::string> > CaseList;
+
+static bool case_less_unsigned(std::pair<int32_t, std::string> const& a, std::pair<int32_t, std::string> const& b) {
+	return (uint32_t)a.first < (uint32_t)b.first;
+}
+
+// compare $10 against cases [first, last), each level halving the candidates
+static void binary_search_cases(std::ostream& out, CaseList const& cases, unsigned first, unsigned last,
+	std::string default_label, bool is_unsigned) {
+	if(last - first <= 3) {
+		for(unsigned i = first; i < last; i++) {
+			if(cases.at(i).first == 0) {
+				out << "    beq     $10, $0, " << cases.at(i).second << "\n";
+			} else {
+				out << "    li      $11, " << cases.at(i).first << "\n";
+				out << "    beq     $10, $11, " << cases.at(i).second << "\n";
+			}
+			out << "    nop\n";
+		}
+		out << "    j       " << default_label << "\n";
+		out << "    nop\n";
+		return;
+	}
+	unsigned middle = (first + last) / 2;
+	std::string lower_label = unique("$L");
+	out << "    li      $11, " << cases.at(middle).first << "\n";
+	out << "    beq     $10, $11, " << cases.at(middle).second << "\n";
 	out << "    nop\n";
-	out << "   " << skip_label << ":\n";
+	out << "    " << (is_unsigned ? "sltu" : "slt ") << "    $11, $10, $11\n";
+	out << "    bne     $11, $0, " << lower_label << "\n";
+	out << "    nop\n";
+	binary_search_cases(out, cases, middle + 1, last, default_label, is_unsigned);
+	out << "   " << lower_label << ":\n";
+	binary_search_cases(out, cases, first, middle, default_label, is_unsigned);
+}
+
+void SwitchInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	Type type = context.get_type(variable);
+	context.load_variable(out, variable, 8);
+	convert_type(out, 8, type, 10, Type("int", 0));
+
+	if(jump_table) {
+		int32_t low = cases.begin()->first;
+		uint32_t entries = (uint32_t)cases.rbegin()->first - (uint32_t)low + 1;
+		std::string table = unique("switch_table");
+
+		// addresses of the cases in read-only data, gaps go to the default
+		buff << "    .rdata\n";
+		buff << "    .align 2\n";
+		buff << "  " << table << ":\n";
+		for(uint32_t i = 0; i < entries; i++) {
+			int32_t value = (int32_t)((uint32_t)low + i);
+			buff << "    .word " << get_label(value) << "\n";
+		}
+		buff << "    .data\n";
+
+		// index = value - low, anything outside the table is the default
+		if(low != 0) {
+			if(low > -32768 && low <= 32768) {
+				out << "    addiu   $10, $10, " << -low << "\n";
+			} else {
+				out << "    li      $11, " << low << "\n";
+				out << "    subu    $10, $10, $11\n";
+			}
+		}
+		out << "    sltiu   $11, $10, " << entries << "\n";
+		out << "    beq     $11, $0, " << default_label << "\n";
+		out << "    nop\n";
+		out << "    sll     $10, $10, 2\n";
+		out << "    lui     $11, %hi(" << table << ")\n";
+		out << "    addu    $11, $11, $10\n";
+		out << "    lw      $11, %lo(" << table << ")($11)\n";
+		out << "    nop\n";
+		out << "    jr      $11\n";
+		out << "    nop\n";
+	} else {
+		// the promoted type decides whether the cases are ordered as signed or unsigned
+		bool is_unsigned = type.is_integer() && !type.is_signed() && type.bytes() == 4 && !type.is_enum();
+		CaseList sorted(cases.begin(), cases.end());
+		if(is_unsigned) {
+			std::sort(sorted.begin(), sorted.end(), case_less_unsigned);
+		}
+		binary_search_cases(out, sorted, 0, sorted.size(), default_label, is_unsigned);
+	}
+}
+
+std::vector<std::string> SwitchInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(variable);
+	return sources;
+}
+
+std::string SwitchInstruction::get_variable() const {
+	return variable;
+}
+
+std::string SwitchInstruction::get_label(int32_t value) const {
+	std::map<int32_t, std::string>::const_iterator itr = cases.find(value);
+	return itr == cases.end() ? default_label : itr->second;
+}
+
+std::vector<std::string> SwitchInstruction::get_labels() const {
+	std::vector<std::string> labels;
+	for(std::map<int32_t, std::string>::const_iterator itr = cases.begin(); itr != cases.end(); ++itr) {
+		labels.push_back(itr->second);
+	}
+	labels.push_back(default_label);
+	return labels;
+}
+
+bool SwitchInstruction::uses_jump_table() const {
+	return jump_table;
 }
 
 // *******************************************
@@ -63,6 +683,14 @@ void GotoIfEqualInstruction::PrintMIPS(std::ostream& out, IRContext& context, st
 ReturnInstruction::ReturnInstruction() : return_variable("") {}
 ReturnInstruction::ReturnInstruction(std::string return_variable) : return_variable(return_variable) {}
 
+Instruction* ReturnInstruction::clone() const {
+	return new ReturnInstruction(*this);
+}
+
+void ReturnInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, return_variable);
+}
+
 void ReturnInstruction::Debug(std::ostream &dst) const {
 	dst << "    return " << return_variable << std::endl;
 }
@@ -99,11 +727,25 @@ void ReturnInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::os
 	out << "    nop\n";
 }
 
+std::vector<std::string> ReturnInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	if(return_variable != "") sources.push_back(return_variable);
+	return sources;
+}
+
 // *******************************************
 
 ConstantInstruction::ConstantInstruction(std::string destination, Type type, uint32_t dataLo, uint32_t dataHi)
 : destination(destination), type(type), dataLo(dataLo), dataHi(dataHi) {}
 
+Instruction* ConstantInstruction::clone() const {
+	return new ConstantInstruction(*this);
+}
+
+void ConstantInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+}
+
 void ConstantInstruction::Debug(std::ostream &dst) const {
 	dst << "    constant " << destination
 	<< " "
@@ -127,6 +769,21 @@ void ConstantInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::
 	context.store_variable(out, destination, 8);
 }
 
+std::string ConstantInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> ConstantInstruction::get_sources() const {
+	return std::vector<std::string>();
+}
+
+bool ConstantInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	if(type.bytes() == 8 || !type.is_integer() || !integer_variable(stack, destination, d)) return false;
+	result = convert_constant(dataLo, d);
+	return true;
+}
+
 std::string very_conservative_escape(std::string src) {
 	std::stringstream ss;
 	for(unsigned i = 0; i < src.size(); i++) {
@@ -143,6 +800,14 @@ std::string very_conservative_escape(std::string src) {
 StringInstruction::StringInstruction(std::string destination, std::string data)
 : destination(destination), data(data) {}
 
+Instruction* StringInstruction::clone() const {
+	return new StringInstruction(*this);
+}
+
+void StringInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+}
+
 void StringInstruction::Debug(std::ostream &dst) const {
 	dst << "    ascii " << destination << " " << data << std::endl;
 }
@@ -158,11 +823,28 @@ void StringInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::os
 	context.store_variable(out, destination, 8);
 }
 
+std::string StringInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> StringInstruction::get_sources() const {
+	return std::vector<std::string>();
+}
+
 // *******************************************
 
 MoveInstruction::MoveInstruction(std::string destination, std::string source)
 : destination(destination), source(source) {}
 
+Instruction* MoveInstruction::clone() const {
+	return new MoveInstruction(*this);
+}
+
+void MoveInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source);
+}
+
 void MoveInstruction::Debug(std::ostream &dst) const {
 	dst << "    move " << destination << ", " << source << std::endl;
 }
@@ -179,45 +861,131 @@ void MoveInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostr
 	}
 }
 
+std::string MoveInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> MoveInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source);
+	return sources;
+}
+
+bool MoveInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source, a)) return false;
+	result = convert_constant(a, d);
+	return true;
+}
+
 AssignInstruction::AssignInstruction(std::string destination, std::string source)
-: destination(destination), source(source) {}
+: destination(destination), source(source), offset(0), direct(false), folded(false) {}
+
+Instruction* AssignInstruction::clone() const {
+	return new AssignInstruction(*this);
+}
+
+void AssignInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source);
+}
 
 void AssignInstruction::Debug(std::ostream &dst) const {
-	dst << "    assign *" << destination << ", " << source << std::endl;
+	dst << "    assign *";
+	if(direct) {
+		dst << "(&" << destination << " + " << offset << ")";
+	} else if(offset != 0) {
+		dst << "(" << destination << " + " << offset << ")";
+	} else {
+		dst << destination;
+	}
+	dst << ", " << source << std::endl;
 }
 
 void AssignInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
 	// get the address of the destination to assign
-	context.load_variable(out, destination, 3);
+	Type target = folded ? this->target : context.get_type(destination).dereference();
+	std::string base;
+	int32_t displacement = context.memory_address(out, destination, offset, direct, 3, base);
 
-	if(context.get_type(destination).dereference().is_struct() && context.get_type(destination).dereference().equals(context.get_type(source))) {
+	if(target.is_struct() && target.equals(context.get_type(source))) {
 		// do a byte-wise copy
-		context.copy(out, source, "", context.get_type(destination).dereference().bytes());
+		out << "    addiu   $3, " << base << ", " << displacement << "\n";
+		context.copy(out, source, "", target.bytes());
 	} else {
 		// do a conversion
 		context.load_variable(out, source, 8);
-		convert_type(out, 8, context.get_type(source), 10, context.get_type(destination).dereference());
-		switch (context.get_type(destination).dereference().bytes()) {
+		convert_type(out, 8, context.get_type(source), 10, target);
+		switch (target.bytes()) {
 			case 1:
-				out << "    sb      $10, 0($3)\n"; break;
+				out << "    sb      $10, " << displacement << "(" << base << ")\n"; break;
 			case 2:
-				out << "    sh      $10, 0($3)\n"; break;
+				out << "    sh      $10, " << displacement << "(" << base << ")\n"; break;
 			case 4:
-				out << "    sw      $10, 0($3)\n"; break;
+				out << "    sw      $10, " << displacement << "(" << base << ")\n"; break;
 			case 8:
-				out << "    sw      $10, 0($3)\n";
-				out << "    sw      $11, 4($3)\n";
+				out << "    sw      $10, " << displacement << "(" << base << ")\n";
+				out << "    sw      $11, " << displacement + 4 << "(" << base << ")\n";
 				break;
 		}
 		out << "    nop\n";
 	}
 }
 
+std::vector<std::string> AssignInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	if(!direct) sources.push_back(destination);
+	sources.push_back(source);
+	return sources;
+}
+
+std::string AssignInstruction::get_addressed_variable() const {
+	return direct ? destination : "";
+}
+
+std::string AssignInstruction::get_pointer() const {
+	return direct ? "" : destination;
+}
+
+int32_t AssignInstruction::get_offset() const {
+	return offset;
+}
+
+Type AssignInstruction::stored_type(FunctionStack const& stack) const {
+	if(folded) return target;
+	return stack.count(destination) ? stack.at(destination).dereference() : Type();
+}
+
+unsigned AssignInstruction::stored_bytes(FunctionStack const& stack) const {
+	if(!folded && !stack.count(destination)) return 0;
+	return stored_type(stack).bytes();
+}
+
+void AssignInstruction::fold_address(std::string base, int32_t offset, bool direct, FunctionStack const& stack) {
+	if(!folded) {
+		target = stack.at(destination).dereference();
+		folded = true;
+	}
+	this->destination = base;
+	this->offset += offset;
+	this->direct = direct;
+}
+
 // *******************************************
 
 AddressOfInstruction::AddressOfInstruction(std::string destination, std::string source)
 : destination(destination), source(source) {}
 
+Instruction* AddressOfInstruction::clone() const {
+	return new AddressOfInstruction(*this);
+}
+
+void AddressOfInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source);
+}
+
 void AddressOfInstruction::Debug(std::ostream &dst) const {
 	dst << "    addressOf " << destination << ", &" << source << std::endl;
 }
@@ -232,23 +1000,78 @@ void AddressOfInstruction::PrintMIPS(std::ostream& out, IRContext& context, std:
 	context.store_variable(out, destination, 8);
 }
 
+std::string AddressOfInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> AddressOfInstruction::get_sources() const {
+	return std::vector<std::string>();
+}
+
+std::string AddressOfInstruction::get_addressed_variable() const {
+	return source;
+}
+
+std::string AddressOfInstruction::get_variable() const {
+	return source;
+}
+
 DereferenceInstruction::DereferenceInstruction(std::string destination, std::string source)
-: destination(destination), source(source) {}
+: destination(destination), source(source), offset(0), direct(false) {}
 
-void DereferenceInstruction::Debug(std::ostream &dst) const {
-	dst << "    dereference " << destination << ", *" << source << std::endl;
+Instruction* DereferenceInstruction::clone() const {
+	return new DereferenceInstruction(*this);
 }
 
-void DereferenceInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
-	if(context.is_global(source)) {
-		out << "    lui     $2, %hi(" << source << ")\n";
-		out << "    addiu   $2, $2, %lo(" << source << ")\n";
-		out << "    lw      $2, 0($2)\n";
+void DereferenceInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source);
+}
+
+void DereferenceInstruction::Debug(std::ostream &dst) const {
+	dst << "    dereference " << destination << ", *";
+	if(direct) {
+		dst << "(&" << source << " + " << offset << ")";
+	} else if(offset != 0) {
+		dst << "(" << source << " + " << offset << ")";
 	} else {
-		out << "    lw      $2, " << context.get_stack_offset(source) << "($fp)\n";
+		dst << source;
 	}
-	out << "    nop\n";
-	context.copy(out, "", destination, context.get_type(destination).bytes());
+	dst << std::endl;
+}
+
+void DereferenceInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	std::string base;
+	int32_t displacement = context.memory_address(out, source, offset, direct, 2, base);
+	context.load_indirect(out, destination, base, displacement);
+}
+
+std::string DereferenceInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> DereferenceInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	if(!direct) sources.push_back(source);
+	return sources;
+}
+
+std::string DereferenceInstruction::get_addressed_variable() const {
+	return direct ? source : "";
+}
+
+std::string DereferenceInstruction::get_pointer() const {
+	return direct ? "" : source;
+}
+
+int32_t DereferenceInstruction::get_offset() const {
+	return offset;
+}
+
+void DereferenceInstruction::fold_address(std::string base, int32_t offset, bool direct) {
+	this->source = base;
+	this->offset += offset;
+	this->direct = direct;
 }
 
 // *******************************************
@@ -256,6 +1079,16 @@ void DereferenceInstruction::PrintMIPS(std::ostream& out, IRContext& context, st
 LogicalInstruction::LogicalInstruction(std::string destination, std::string source1, std::string source2, char logicalType)
 : destination(destination), source1(source1), source2(source2), logicalType(logicalType) {}
 
+Instruction* LogicalInstruction::clone() const {
+	return new LogicalInstruction(*this);
+}
+
+void LogicalInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void LogicalInstruction::Debug(std::ostream &dst) const {
 	switch (logicalType) {
 		case '&':
@@ -321,21 +1154,57 @@ void LogicalInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::o
 	context.store_variable(out, destination, 14);
 }
 
+std::string LogicalInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> LogicalInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool LogicalInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a, b = 0;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a)) return false;
+	if(logicalType != '!' && !known_value(known, source2, b)) return false;
+	switch (logicalType) {
+		case '&': result = (a != 0 && b != 0); break;
+		case '|': result = (a != 0 || b != 0); break;
+		case '!': result = (a == 0); break;
+		default: return false;
+	}
+	result = convert_constant(result, d);
+	return true;
+}
+
 // *******************************************
 
 BitwiseInstruction::BitwiseInstruction(std::string destination, std::string source1, std::string source2, char operatorType)
 : destination(destination), source1(source1), source2(source2), operatorType(operatorType) {}
 
+Instruction* BitwiseInstruction::clone() const {
+	return new BitwiseInstruction(*this);
+}
+
+void BitwiseInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void BitwiseInstruction::Debug(std::ostream &dst) const {
 	switch (operatorType) {
 		case '&':
-			dst << "    bitwiseAnd " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    bitwiseAnd " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case '|':
-			dst << "    bitwiseOr " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    bitwiseOr " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case '^':
-			dst << "    bitwiseXor " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    bitwiseXor " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case '~':
 			dst << "    bitwiseNot " << destination << ", " << source1 << std::endl;
@@ -349,6 +1218,19 @@ void BitwiseInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::o
 	if(!context.get_type(source1).is_integer()) {
 		throw compile_error("cannot perform a bitwise operation on structs, unions, or floats");
 	}
+	if(immediate.bound) {
+		// andi/ori/xori zero-extend their 16 bits
+		unsigned a = context.use_register(out, source1, 8);
+		switch (operatorType) {
+			case '&': out << "    andi    $10, $" << a << ", " << immediate.value << "\n"; break;
+			case '|': out << "    ori     $10, $" << a << ", " << immediate.value << "\n"; break;
+			case '^': out << "    xori    $10, $" << a << ", " << immediate.value << "\n"; break;
+			default:
+				throw compile_error("unsupported type of boolean operator in BitwiseInstruction");
+		}
+		context.store_variable(out, destination, 10);
+		return;
+	}
 	if(operatorType != '~') {
 		if(!context.get_type(source2).is_integer()) {
 			throw compile_error("cannot perform a bitwise operation on structs, unions, or floats");
@@ -378,30 +1260,82 @@ void BitwiseInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::o
 	context.store_variable(out, destination, 10);
 }
 
+std::string BitwiseInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> BitwiseInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool BitwiseInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a, b = 0;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a)) return false;
+	if(operatorType != '~' && !operand_value(known, source2, immediate, b)) return false;
+	switch (operatorType) {
+		case '&': result = a & b; break;
+		case '|': result = a | b; break;
+		case '^': result = a ^ b; break;
+		case '~': result = ~a; break;
+		default: return false;
+	}
+	result = convert_constant(result, d);
+	return true;
+}
+
+bool BitwiseInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t, other;
+	if(immediate.bound || operatorType == '~' || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(!fits_unsigned16(value)) return false;
+	if(source == source1) {
+		std::swap(source1, source2);
+	}
+	if(!integer_variable(stack, source1, other)) return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
 // *******************************************
 
 EqualityInstruction::EqualityInstruction(std::string destination, std::string source1, std::string source2, char equalityType)
 : destination(destination), source1(source1), source2(source2), equalityType(equalityType) {}
 
+Instruction* EqualityInstruction::clone() const {
+	return new EqualityInstruction(*this);
+}
+
+void EqualityInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void EqualityInstruction::Debug(std::ostream &dst) const {
 	switch (equalityType) {
 		case '=':
-			dst << "    equals " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    equals " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case '!':
-			dst << "    notEquals " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    notEquals " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case '<':
-			dst << "    lessThan " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    lessThan " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case '>':
-			dst << "    greaterThan " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    greaterThan " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case 'l':
-			dst << "    lessOrEq " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    lessOrEq " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		case 'g':
-			dst << "    greaterOrEq " << destination << ", " << source1 << ", " << source2 << std::endl;
+			dst << "    greaterOrEq " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 			break;
 		default:
 			throw compile_error("unsupported type of relational operator in EqualityInstruction");
@@ -440,6 +1374,40 @@ void fpu_comparison_instruction(std::ostream& out, char equalityType, std::strin
 }
 
 void EqualityInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	if(immediate.bound) {
+		// branch-free: slti/sltiu for the orderings, a difference tested against zero for == and !=
+		Type l = context.get_type(source1);
+		bool is_signed = l.is_signed() && immediate.type.is_signed();
+		unsigned a = context.use_register(out, source1, 8);
+		int32_t bound;
+		if(compare_bound(equalityType, immediate.value, is_signed, bound)) {
+			out << "    " << (is_signed ? "slti " : "sltiu") << "   $24, $" << a << ", " << bound << "\n";
+			if(equalityType == '>' || equalityType == 'g') {
+				out << "    xori    $24, $24, 1\n";
+			}
+		} else if(equalityType == '=' || equalityType == '!') {
+			if(immediate.value == 0) {
+				out << "    move    $24, $" << a << "\n";
+			} else if(fits_unsigned16(immediate.value)) {
+				out << "    xori    $24, $" << a << ", " << immediate.value << "\n";
+			} else if(fits_signed16(-(int64_t)immediate.value)) {
+				out << "    addiu   $24, $" << a << ", " << -(int64_t)immediate.value << "\n";
+			} else {
+				out << "    li      $9, " << immediate.value << "\n";
+				out << "    xor     $24, $" << a << ", $9\n";
+			}
+			if(equalityType == '=') {
+				out << "    sltiu   $24, $24, 1\n";
+			} else {
+				out << "    sltu    $24, $0, $24\n";
+			}
+		} else {
+			throw compile_error("immediate operand out of range in EqualityInstruction");
+		}
+		context.store_variable(out, destination, 24);
+		return;
+	}
+
 	out << "    li      $24, 1\n";
 	std::string skip_label = unique("$L");
 	Type l = context.get_type(source1);
@@ -547,13 +1515,56 @@ void EqualityInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::
 			fpu_comparison_instruction(out, equalityType, "s", skip_label);
 		}
 
-	} else {
-		throw compile_error((std::string)"relational operator not defined between types '" + l.name() + "' and '" + r.name() + "'");
+	} else {
+		throw compile_error((std::string)"relational operator not defined between types '" + l.name() + "' and '" + r.name() + "'");
+	}
+	out << "    nop\n";
+	out << "    li      $24, 0\n";
+	out << "   " << skip_label << ":\n";
+	context.store_variable(out, destination, 24);
+}
+
+std::string EqualityInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> EqualityInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool EqualityInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d, l, r;
+	int32_t a, b;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a) || !operand_value(known, source2, immediate, b)) return false;
+	if(!integer_variable(stack, source1, l)) return false;
+	if(immediate.bound) {
+		r = immediate.type;
+	} else if(!integer_variable(stack, source2, r)) {
+		return false;
 	}
-	out << "    nop\n";
-	out << "    li      $24, 0\n";
-	out << "   " << skip_label << ":\n";
-	context.store_variable(out, destination, 24);
+	result = convert_constant(compare_values(equalityType, a, b, l.is_signed() && r.is_signed()), d);
+	return true;
+}
+
+bool EqualityInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t, other;
+	if(immediate.bound || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(source == source1) {
+		std::swap(source1, source2);
+		equalityType = mirror_relation(equalityType);
+	}
+	if(!comparable_variable(stack, source1, other)) return false;
+	int32_t bound;
+	if(!compare_bound(equalityType, value, other.is_signed() && t.is_signed(), bound)
+		&& equalityType != '=' && equalityType != '!') return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
 }
 
 // *******************************************
@@ -561,11 +1572,21 @@ void EqualityInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::
 ShiftInstruction::ShiftInstruction(std::string destination, std::string source1, std::string source2, bool doRightShift)
 : destination(destination), source1(source1), source2(source2), doRightShift(doRightShift) {}
 
+Instruction* ShiftInstruction::clone() const {
+	return new ShiftInstruction(*this);
+}
+
+void ShiftInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void ShiftInstruction::Debug(std::ostream &dst) const {
 	if(doRightShift) {
-		dst << "    rightshift " << destination << ", " << source1 << ", " << source2 << std::endl;
+		dst << "    rightshift " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 	} else {
-		dst << "    leftshift " << destination << ", " << source1 << ", " << source2 << std::endl;
+		dst << "    leftshift " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 	}
 }
 
@@ -573,6 +1594,14 @@ void ShiftInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ost
 	if(!context.get_type(source1).is_integer() || !context.get_type(source1).is_integer()) {
 		throw compile_error("cannot perform a shift operation on structs, unions, or floats");
 	}
+	if(immediate.bound) {
+		// the variable forms only look at the low five bits of the amount, and so do we
+		unsigned a = context.use_register(out, source1, 8);
+		std::string opcode = !doRightShift ? "sll " : context.get_type(source1).is_signed() ? "sra " : "srl ";
+		out << "    " << opcode << "    $10, $" << a << ", " << (immediate.value & 31) << "\n";
+		context.store_variable(out, destination, 10);
+		return;
+	}
 	context.load_variable(out, source1, 8);
 	context.load_variable(out, source2, 9);
 	if(doRightShift) {
@@ -587,11 +1616,60 @@ void ShiftInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ost
 	context.store_variable(out, destination, 10);
 }
 
+std::string ShiftInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> ShiftInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool ShiftInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d, l;
+	int32_t a, b;
+	if(!integer_variable(stack, destination, d) || !integer_variable(stack, source1, l)) return false;
+	if(!known_value(known, source1, a) || !operand_value(known, source2, immediate, b)) return false;
+	// sllv/srlv/srav only look at the low five bits of the amount
+	unsigned amount = b & 31;
+	if(!doRightShift) {
+		result = (uint32_t)a << amount;
+	} else if(l.is_signed()) {
+		result = a < 0 ? ~(~a >> amount) : a >> amount;
+	} else {
+		result = (uint32_t)a >> amount;
+	}
+	result = convert_constant(result, d);
+	return true;
+}
+
+bool ShiftInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t, other;
+	if(immediate.bound || source != source2 || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(!integer_variable(stack, source1, other)) return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
 // *******************************************
 
 NegativeInstruction::NegativeInstruction(std::string destination, std::string source)
 : destination(destination), source(source) {}
 
+Instruction* NegativeInstruction::clone() const {
+	return new NegativeInstruction(*this);
+}
+
+void NegativeInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source);
+}
+
 void NegativeInstruction::Debug(std::ostream &dst) const {
 	dst << "    negative " << destination << ", " << source << std::endl;
 }
@@ -624,6 +1702,24 @@ void NegativeInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::
 	}
 }
 
+std::string NegativeInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> NegativeInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source);
+	return sources;
+}
+
+bool NegativeInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source, a)) return false;
+	result = convert_constant(0u - (uint32_t)a, d);
+	return true;
+}
+
 // *******************************************
 
 void float_operation(std::string type, std::ostream& out) {
@@ -652,6 +1748,15 @@ void double_operation(std::string type, std::ostream& out) {
 IncrementInstruction::IncrementInstruction(std::string destination, std::string source, bool decrement)
 : destination(destination), source(source), decrement(decrement) {}
 
+Instruction* IncrementInstruction::clone() const {
+	return new IncrementInstruction(*this);
+}
+
+void IncrementInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source);
+}
+
 void IncrementInstruction::Debug(std::ostream &dst) const {
 	if(decrement) {
 		dst << "    decrement " << destination << ", " << source << std::endl;
@@ -682,6 +1787,7 @@ void IncrementInstruction::PrintMIPS(std::ostream& out, IRContext& context, std:
 		} else {
 			out << "    addiu   $10, $8, " << context.get_type(source).dereference().bytes() << "\n";
 		}
+		context.store_variable(out, destination, 10);
 
 	} else if(context.get_type(source).bytes() == 4) {
 		// float
@@ -700,16 +1806,64 @@ void IncrementInstruction::PrintMIPS(std::ostream& out, IRContext& context, std:
 	}
 }
 
+std::string IncrementInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> IncrementInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source);
+	return sources;
+}
+
+bool IncrementInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source, a)) return false;
+	result = convert_constant(decrement ? (uint32_t)a - 1 : (uint32_t)a + 1, d);
+	return true;
+}
+
+bool IncrementInstruction::address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const {
+	Type l;
+	if(!comparable_variable(stack, source, l) || !l.is_pointer()) return false;
+	base = source;
+	offset = (decrement ? -1 : 1) * (int32_t)l.dereference().bytes();
+	return true;
+}
+
 // *******************************************
 
 AddInstruction::AddInstruction(std::string destination, std::string source1, std::string source2)
 : destination(destination), source1(source1), source2(source2) {}
 
+Instruction* AddInstruction::clone() const {
+	return new AddInstruction(*this);
+}
+
+void AddInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void AddInstruction::Debug(std::ostream &dst) const {
-	dst << "    add " << destination << ", " << source1 << ", " << source2 << std::endl;
+	dst << "    add " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 }
 
 void AddInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	if(immediate.bound) {
+		// addiu, with the constant already scaled for pointer arithmetic
+		int32_t value = immediate.value;
+		if(context.get_type(source1).is_pointer()) {
+			value *= context.get_type(source1).dereference().bytes();
+		}
+		unsigned a = context.use_register(out, source1, 8);
+		out << "    addiu   $8, $" << a << ", " << value << "\n";
+		context.store_variable(out, destination, 8);
+		return;
+	}
+
 	// load the two operands in registers
 	context.load_variable(out, source1, 8);
 	context.load_variable(out, source2, 10);
@@ -717,16 +1871,14 @@ void AddInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostre
 	// special case: pointer arithmetic
 	if(context.get_type(source1).is_pointer()) {
 		if(context.get_type(source2).is_integer()) {
-			out << "    li      $11, " << context.get_type(source1).dereference().bytes() << "\n";
-			out << "    mul     $10, $10, $11\n";
+			scale_offset(out, 10, context.get_type(source1).dereference().bytes());
 		}
 		out << "    addu    $14, $8, $10\n";
 		context.store_variable(out, destination, 14);
 		return;
 	}
 	if(context.get_type(source2).is_pointer()) {
-		out << "    li      $11, " << context.get_type(source2).dereference().bytes() << "\n";
-		out << "    mul     $8, $8, $11\n";
+		scale_offset(out, 8, context.get_type(source2).dereference().bytes());
 		out << "    addu    $14, $8, $10\n";
 		context.store_variable(out, destination, 14);
 		return;
@@ -749,24 +1901,98 @@ void AddInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostre
 	}
 }
 
+std::string AddInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> AddInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool AddInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a, b;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a) || !operand_value(known, source2, immediate, b)) return false;
+	result = convert_constant((uint32_t)convert_constant(a, d) + (uint32_t)convert_constant(b, d), d);
+	return true;
+}
+
+// the constant added by addiu: scaled by the element size when added to a pointer
+static bool address_immediate(FunctionStack const& stack, std::string destination, std::string source, int64_t value) {
+	Type d, l;
+	if(!comparable_variable(stack, destination, d) || !comparable_variable(stack, source, l)) return false;
+	if(l.is_pointer()) {
+		value *= l.dereference().bytes();
+	} else if(d.is_pointer()) {
+		return false;
+	}
+	return fits_signed16(value);
+}
+
+bool AddInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t;
+	if(immediate.bound || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(source == source1) {
+		std::swap(source1, source2);
+	}
+	if(!address_immediate(stack, destination, source1, value)) return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
+bool AddInstruction::address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const {
+	Type l;
+	if(!immediate.bound || !comparable_variable(stack, source1, l) || !l.is_pointer()) return false;
+	base = source1;
+	offset = immediate.value * (int32_t)l.dereference().bytes();
+	return true;
+}
+
 // *******************************************
 
 SubInstruction::SubInstruction(std::string destination, std::string source1, std::string source2)
 : destination(destination), source1(source1), source2(source2) {}
 
+Instruction* SubInstruction::clone() const {
+	return new SubInstruction(*this);
+}
+
+void SubInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void SubInstruction::Debug(std::ostream &dst) const {
-	dst << "    sub " << destination << ", " << source1 << ", " << source2 << std::endl;
+	dst << "    sub " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 }
 
 void SubInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	if(immediate.bound) {
+		// subtracting is adding the negated constant
+		int32_t value = -immediate.value;
+		if(context.get_type(source1).is_pointer()) {
+			value *= context.get_type(source1).dereference().bytes();
+		}
+		unsigned a = context.use_register(out, source1, 8);
+		out << "    addiu   $8, $" << a << ", " << value << "\n";
+		context.store_variable(out, destination, 8);
+		return;
+	}
+
 	// load the two operands in registers
 	context.load_variable(out, source1, 8);
 	context.load_variable(out, source2, 10);
 	// special case: pointer arithmetic
 	if(context.get_type(source1).is_pointer()) {
 		if(context.get_type(source2).is_integer()) {
-			out << "    li      $11, " << context.get_type(source1).dereference().bytes() << "\n";
-			out << "    mul     $10, $10, $11\n";
+			scale_offset(out, 10, context.get_type(source1).dereference().bytes());
 		}
 		out << "    subu    $14, $8, $10\n";
 		context.store_variable(out, destination, 14);
@@ -789,16 +2015,76 @@ void SubInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostre
 	}
 }
 
+std::string SubInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> SubInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool SubInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a, b;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a) || !operand_value(known, source2, immediate, b)) return false;
+	result = convert_constant((uint32_t)convert_constant(a, d) - (uint32_t)convert_constant(b, d), d);
+	return true;
+}
+
+bool SubInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t;
+	if(immediate.bound || source != source2 || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(!address_immediate(stack, destination, source1, -(int64_t)value)) return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
+bool SubInstruction::address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const {
+	Type l;
+	if(!immediate.bound || !comparable_variable(stack, source1, l) || !l.is_pointer()) return false;
+	base = source1;
+	offset = -immediate.value * (int32_t)l.dereference().bytes();
+	return true;
+}
+
 // *******************************************
 
 MulInstruction::MulInstruction(std::string destination, std::string source1, std::string source2)
 : destination(destination), source1(source1), source2(source2) {}
 
+Instruction* MulInstruction::clone() const {
+	return new MulInstruction(*this);
+}
+
+void MulInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void MulInstruction::Debug(std::ostream &dst) const {
-	dst << "    mul " << destination << ", " << source1 << ", " << source2 << std::endl;
+	dst << "    mul " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 }
 
 void MulInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	if(immediate.bound) {
+		// shifts and adds when the factor allows, otherwise the constant goes in a register
+		unsigned a = context.use_register(out, source1, 12);
+		if(!multiply_by_constant(out, 8, a, immediate.value)) {
+			out << "    li      $14, " << immediate.value << "\n";
+			out << "    mult    $" << a << ", $14\n";
+			out << "    nop\n";
+			out << "    mflo    $8\n";
+		}
+		context.store_variable(out, destination, 8);
+		return;
+	}
 	// load the two operands in registers
 	context.load_variable(out, source1, 8);
 	context.load_variable(out, source2, 10);
@@ -825,16 +2111,84 @@ void MulInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostre
 	}
 }
 
+std::string MulInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> MulInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool MulInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a, b;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a) || !operand_value(known, source2, immediate, b)) return false;
+	result = convert_constant((uint32_t)convert_constant(a, d) * (uint32_t)convert_constant(b, d), d);
+	return true;
+}
+
+bool MulInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t, other, d;
+	if(immediate.bound || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(source == source1) {
+		std::swap(source1, source2);
+	}
+	if(!integer_variable(stack, source1, other) || !integer_variable(stack, destination, d)) return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
 // *******************************************
 
+// a divisor the division can be lowered for: nonzero, into a word-sized integer
+static bool divisor_immediate(FunctionStack const& stack, std::string destination, std::string source, int32_t value) {
+	Type d, l;
+	if(value == 0 || !integer_variable(stack, destination, d) || !integer_variable(stack, source, l)) return false;
+	return d.bytes() == 4;
+}
+
+// register holding the dividend converted to the result type
+static unsigned dividend_register(std::ostream& out, IRContext& context, std::string source, Type result_type) {
+	if(context.get_type(source).bytes() == 4) {
+		return context.use_register(out, source, 12);
+	}
+	context.load_variable(out, source, 8);
+	convert_type(out, 8, context.get_type(source), 12, result_type);
+	return 12;
+}
+
 DivInstruction::DivInstruction(std::string destination, std::string source1, std::string source2)
 : destination(destination), source1(source1), source2(source2) {}
 
+Instruction* DivInstruction::clone() const {
+	return new DivInstruction(*this);
+}
+
+void DivInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void DivInstruction::Debug(std::ostream &dst) const {
-	dst << "    div " << destination << ", " << source1 << ", " << source2 << std::endl;
+	dst << "    div " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 }
 
 void DivInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	if(immediate.bound) {
+		// reciprocal multiplication or shifts instead of div
+		Type result_type = context.get_type(destination);
+		unsigned n = dividend_register(out, context, source1, result_type);
+		divide_by_constant(out, 8, n, immediate.value, result_type.is_signed());
+		context.store_variable(out, destination, 8);
+		return;
+	}
 	// load the two operands in registers
 	context.load_variable(out, source1, 8);
 	context.load_variable(out, source2, 10);
@@ -861,16 +2215,85 @@ void DivInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostre
 	}
 }
 
+std::string DivInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> DivInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool DivInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a, b;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a) || !operand_value(known, source2, immediate, b)) return false;
+	a = convert_constant(a, d);
+	b = convert_constant(b, d);
+	// leave the cases the hardware does not define to run time
+	if(b == 0 || (d.is_signed() && a == (int32_t)0x80000000 && b == -1)) return false;
+	if(d.is_signed()) {
+		result = a / b;
+	} else {
+		result = (uint32_t)a / (uint32_t)b;
+	}
+	result = convert_constant(result, d);
+	return true;
+}
+
+bool DivInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t;
+	if(immediate.bound || source != source2 || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(!divisor_immediate(stack, destination, source1, value)) return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
 // *******************************************
 
 ModInstruction::ModInstruction(std::string destination, std::string source1, std::string source2)
 : destination(destination), source1(source1), source2(source2) {}
 
+Instruction* ModInstruction::clone() const {
+	return new ModInstruction(*this);
+}
+
+void ModInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source1);
+	rename_variable(names, source2);
+}
+
 void ModInstruction::Debug(std::ostream &dst) const {
-	dst << "    mod " << destination << ", " << source1 << ", " << source2 << std::endl;
+	dst << "    mod " << destination << ", " << source1 << ", " << operand_name(source2, immediate) << std::endl;
 }
 
 void ModInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	if(immediate.bound) {
+		// n - (n / d) * d, both steps without div
+		Type result_type = context.get_type(destination);
+		unsigned n = dividend_register(out, context, source1, result_type);
+		uint32_t d = immediate.value;
+		if(!result_type.is_signed() && log2_exact(d) >= 0 && fits_unsigned16(d - 1)) {
+			out << "    andi    $8, $" << n << ", " << d - 1 << "\n";
+		} else {
+			divide_by_constant(out, 10, n, immediate.value, result_type.is_signed());
+			if(!multiply_by_constant(out, 8, 10, immediate.value)) {
+				out << "    li      $11, " << immediate.value << "\n";
+				out << "    mult    $10, $11\n";
+				out << "    nop\n";
+				out << "    mflo    $8\n";
+			}
+			out << "    subu    $8, $" << n << ", $8\n";
+		}
+		context.store_variable(out, destination, 8);
+		return;
+	}
 	// load the two operands in registers
 	context.load_variable(out, source1, 8);
 	context.load_variable(out, source2, 10);
@@ -893,11 +2316,59 @@ void ModInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostre
 	}
 }
 
+std::string ModInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> ModInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source1);
+	if(source2 != "") sources.push_back(source2);
+	return sources;
+}
+
+bool ModInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a, b;
+	if(!integer_variable(stack, destination, d) || !known_value(known, source1, a) || !operand_value(known, source2, immediate, b)) return false;
+	a = convert_constant(a, d);
+	b = convert_constant(b, d);
+	// leave the cases the hardware does not define to run time
+	if(b == 0 || (d.is_signed() && a == (int32_t)0x80000000 && b == -1)) return false;
+	if(d.is_signed()) {
+		result = a % b;
+	} else {
+		result = (uint32_t)a % (uint32_t)b;
+	}
+	result = convert_constant(result, d);
+	return true;
+}
+
+bool ModInstruction::bind_immediate(std::string source, int32_t value, FunctionStack const& stack) {
+	Type t;
+	if(immediate.bound || source != source2 || source1 == source2 || !integer_variable(stack, source, t)) return false;
+	if(!divisor_immediate(stack, destination, source1, value)) return false;
+	immediate.bound = true;
+	immediate.value = value;
+	immediate.type = t;
+	source2 = "";
+	return true;
+}
+
 // *******************************************
 
 CastInstruction::CastInstruction(std::string destination, std::string source, Type cast_type)
 : destination(destination), source(source), cast_type(cast_type) {}
 
+Instruction* CastInstruction::clone() const {
+	return new CastInstruction(*this);
+}
+
+void CastInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, source);
+}
+
 void CastInstruction::Debug(std::ostream &dst) const {
 	dst << "    cast " << destination << ", " << source << ", " << cast_type.name() << std::endl;
 }
@@ -911,13 +2382,42 @@ void CastInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostr
 	context.store_variable(out, destination, 10);
 }
 
+std::string CastInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> CastInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(source);
+	return sources;
+}
+
+bool CastInstruction::evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const {
+	Type d;
+	int32_t a;
+	if(!cast_type.is_integer() || !integer_variable(stack, destination, d) || !known_value(known, source, a)) return false;
+	result = convert_constant(convert_constant(a, cast_type), d);
+	return true;
+}
+
 // *******************************************
 
 FunctionCallInstruction::FunctionCallInstruction(std::string return_result, std::string function_name, std::vector<std::string> arguments)
-: return_result(return_result), function_name(function_name), arguments(arguments) {}
+: return_result(return_result), function_name(function_name), arguments(arguments), tail(false) {}
+
+Instruction* FunctionCallInstruction::clone() const {
+	return new FunctionCallInstruction(*this);
+}
+
+void FunctionCallInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, return_result);
+	for(std::vector<std::string>::iterator itr = arguments.begin(); itr != arguments.end(); ++itr) {
+		rename_variable(names, *itr);
+	}
+}
 
 void FunctionCallInstruction::Debug(std::ostream &dst) const {
-	dst << "    call " << function_name << ", returns " << return_result << std::endl;
+	dst << (tail ? "    tail call " : "    call ") << function_name << ", returns " << return_result << std::endl;
 	for(std::vector<std::string>::const_iterator itr = arguments.begin(); itr != arguments.end(); ++itr) {
 		dst << "      arg " << *itr << std::endl;
 	}
@@ -928,32 +2428,15 @@ void FunctionCallInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 	Type return_type = context.get_type(function_name);
 	std::vector<Type> params = context.get_function_parameters(function_name);
 
-	// calculate the total stack to allocate (plus 8 extra bytes just in case)
-	unsigned allocate = 8;
-	for(std::vector<Type>::const_iterator itr = params.begin(); itr != params.end(); ++itr) {
-		align_address(allocate, itr->is_float() ? 8 : 4, 8);
-		allocate += itr->bytes();
-	}
-	if(arguments.size() > params.size()) { // for ellipsis functions
-		for(unsigned i = params.size(); i < arguments.size(); ++i) {
-			Type arg = context.get_type(arguments.at(i));
-			align_address(allocate, arg.is_float() ? 8 : 4, 8);
-			allocate += arg.bytes();
-		}
-	}
-	if(return_type.is_struct()) {
-		align_address(allocate, 8, 8);
-		allocate += return_type.bytes();
-	}
-	align_address(allocate, 8, 8);
-	out << "    addiu   $sp, $sp, -" << allocate << "\n";
-
+	// the arguments are built at the bottom of the caller's frame, sized by argument_area
 	// check that the signatures are compatible
 	if(params.size() > arguments.size()) {
 		throw compile_error((std::string)"cannot call function '" + function_name + "': incorrect number of parameters.");
 	}
 
-	// convert each argument and put it onto the stack
+	// convert each argument and put it onto the stack, or straight into $4-$7 when it is a word
+	// that arrives there anyway; words left in memory are loaded into their register below
+	std::vector<bool> in_register(4, false);
 	unsigned current_offset = 0;
 	if(return_type.is_struct()) {
 		current_offset += 4;
@@ -973,7 +2456,11 @@ void FunctionCallInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 		} else {
 			context.load_variable(out, arguments.at(i), 8);
 			convert_type(out, 8, orig, 10, target);
-			if(target.bytes() == 8) {
+			if(target.bytes() <= 4 && !target.is_float() && current_offset < 16) {
+				out << "    move    $" << 4 + current_offset / 4 << ", $10\n";
+				in_register.at(current_offset / 4) = true;
+				current_offset += 4;
+			} else if(target.bytes() == 8) {
 				out << "    sw      $10, " << current_offset << "($sp)\n";
 				out << "    sw      $11, " << (current_offset+4) << "($sp)\n";
 				current_offset += 8;
@@ -1009,19 +2496,22 @@ void FunctionCallInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 	}
 
 	// allocate space for returned struct
+	unsigned arguments_end = current_offset;
 	unsigned struct_offset = 0;
 	if(return_type.is_struct()) {
 		align_address(current_offset, 8, 8);
 		struct_offset = current_offset;
 		out << "    addiu   $4, $sp, " << struct_offset << "\n";
 		out << "    sw      $4, 0($sp)\n";
+		in_register.at(0) = true;
 	}
 
-	// put the first 4 words into registers
-	out << "    lw      $4, 0($sp)\n";
-	out << "    lw      $5, 4($sp)\n";
-	out << "    lw      $6, 8($sp)\n";
-	out << "    lw      $7, 12($sp)\n";
+	// put the rest of the first 4 words into registers
+	for(unsigned word = 0; word < 4 && word * 4 < arguments_end; word++) {
+		if(!in_register.at(word)) {
+			out << "    lw      $" << 4 + word << ", " << 4 * word << "($sp)\n";
+		}
+	}
 
 	// put floats into their registers if necessary
 	if(params.size() > 0 && params.at(0).is_float()) {
@@ -1039,6 +2529,16 @@ void FunctionCallInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 		}
 	}
 
+	// the callee returns to our caller: it finds its arguments in registers
+	if(tail) {
+		out << context.get_epilogue();
+		out << "    .option	pic0\n";
+		out << "    j       " << function_name << "\n";
+		out << "    nop\n";
+		out << "    .option	pic2\n";
+		return;
+	}
+
 	// jump and link
 	out << "    .option	pic0\n";
 	out << "    jal     " << function_name << "\n";
@@ -1048,8 +2548,10 @@ void FunctionCallInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 	// store the result of the function call into our destination
 	if(return_type.is_struct()) {
 		// copy the struct from its address into the destination
-		out << "    addiu   $2, $sp, " << struct_offset << "\n";
-		context.copy(out, "", return_result, return_type.bytes());
+		if(return_result != "") {
+			out << "    addiu   $2, $sp, " << struct_offset << "\n";
+			context.copy(out, "", return_result, return_type.bytes());
+		}
 	} else {
 		if(return_type.is_float()) {
 			if(return_type.bytes() == 8) {
@@ -1060,12 +2562,54 @@ void FunctionCallInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 				out << "    mfc1    $2, $f0\n";
 			}
 		}
-		if(return_type.builtin_type != Type::Void)
+		if(return_type.builtin_type != Type::Void && return_result != "")
 			context.store_variable(out, return_result, 2);
 	}
+}
+
+unsigned FunctionCallInstruction::argument_area(IRContext const& context) const {
+	Type return_type = context.get_type(function_name);
+	std::vector<Type> params = context.get_function_parameters(function_name);
+
+	// the arguments and any returned struct (plus 8 extra bytes just in case)
+	unsigned allocate = 8;
+	for(std::vector<Type>::const_iterator itr = params.begin(); itr != params.end(); ++itr) {
+		align_address(allocate, itr->is_float() ? 8 : 4, 8);
+		allocate += itr->bytes();
+	}
+	if(arguments.size() > params.size()) { // for ellipsis functions
+		for(unsigned i = params.size(); i < arguments.size(); ++i) {
+			Type arg = context.get_type(arguments.at(i));
+			align_address(allocate, arg.is_float() ? 8 : 4, 8);
+			allocate += arg.bytes();
+		}
+	}
+	if(return_type.is_struct()) {
+		align_address(allocate, 8, 8);
+		allocate += return_type.bytes();
+	}
+	align_address(allocate, 8, 8);
+	return allocate;
+}
+
+std::string FunctionCallInstruction::get_destination() const {
+	return return_result;
+}
+
+std::vector<std::string> FunctionCallInstruction::get_sources() const {
+	return arguments;
+}
+
+void FunctionCallInstruction::set_tail() {
+	tail = true;
+}
+
+std::string FunctionCallInstruction::get_function_name() const {
+	return function_name;
+}
 
-	// free the stack
-	out << "    addiu   $sp, $sp, " << allocate << "\n";
+std::vector<std::string> FunctionCallInstruction::get_arguments() const {
+	return arguments;
 }
 
 // *******************************************
@@ -1073,6 +2617,15 @@ void FunctionCallInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 MemberAccessInstruction::MemberAccessInstruction(std::string destination, std::string base, unsigned offset)
 : destination(destination), base(base), offset(offset) {}
 
+Instruction* MemberAccessInstruction::clone() const {
+	return new MemberAccessInstruction(*this);
+}
+
+void MemberAccessInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	rename_variable(names, base);
+}
+
 void MemberAccessInstruction::Debug(std::ostream &dst) const {
 	dst << "    member " << destination << ", " << base << " + " << offset << std::endl;
 }
@@ -1082,3 +2635,67 @@ void MemberAccessInstruction::PrintMIPS(std::ostream& out, IRContext& context, s
 	out << "    addiu   $8, $8, " << offset << "\n";
 	context.store_variable(out, destination, 8);
 }
+
+std::string MemberAccessInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> MemberAccessInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	sources.push_back(base);
+	return sources;
+}
+
+bool MemberAccessInstruction::address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const {
+	base = this->base;
+	offset = this->offset;
+	return true;
+}
+
+// *******************************************
+
+PhiInstruction::PhiInstruction(std::string destination)
+: destination(destination) {}
+
+Instruction* PhiInstruction::clone() const {
+	return new PhiInstruction(*this);
+}
+
+void PhiInstruction::rename(std::map<std::string, std::string> const& names) {
+	rename_variable(names, destination);
+	for(std::map<std::string, std::string>::iterator itr = incoming.begin(); itr != incoming.end(); ++itr) {
+		rename_variable(names, itr->second);
+	}
+}
+
+void PhiInstruction::Debug(std::ostream &dst) const {
+	dst << "    phi " << destination;
+	for(std::map<std::string, std::string>::const_iterator itr = incoming.begin(); itr != incoming.end(); ++itr) {
+		dst << ", [" << itr->first << ": " << itr->second << "]";
+	}
+	dst << std::endl;
+}
+
+void PhiInstruction::PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const {
+	throw compile_error("phi instruction left in the code after leaving SSA form");
+}
+
+std::string PhiInstruction::get_destination() const {
+	return destination;
+}
+
+std::vector<std::string> PhiInstruction::get_sources() const {
+	std::vector<std::string> sources;
+	for(std::map<std::string, std::string>::const_iterator itr = incoming.begin(); itr != incoming.end(); ++itr) {
+		sources.push_back(itr->second);
+	}
+	return sources;
+}
+
+std::map<std::string, std::string> const& PhiInstruction::get_incoming() const {
+	return incoming;
+}
+
+void PhiInstruction::set_incoming(std::string label, std::string source) {
+	incoming[label] = source;
+}
@@ -1,6 +1,7 @@
 #ifndef IR_INSTRUCTION_H
 #define IR_INSTRUCTION_H
 
+#include <map>
 #include <string>
 #include <iostream>
 #include <vector>
@@ -13,10 +14,44 @@
 
 // *******************************************
 
+// integer variables whose value is known at compile time, as they would read back from memory
+typedef std::map<std::string, int32_t> ConstantValues;
+
+// a constant operand folded into the instruction in place of a variable
+struct ImmediateOperand {
+	bool bound;
+	int32_t value;
+	// type of the variable it replaced
+	Type type;
+
+	ImmediateOperand();
+};
+
 class Instruction {
 public:
+	virtual ~Instruction() {}
+
 	virtual void Debug(std::ostream& dst) const = 0;
+	// a separate copy, for code that is emitted more than once
+	virtual Instruction* clone() const = 0;
+	// read and write the variables names maps them to instead
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+
+	// variable written by this instruction ("" if none) and variables read by it
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+
+	// integer written to the destination when the sources are known, false if it cannot be worked out
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+
+	// use value as an immediate operand instead of reading source, false if there is no such form
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
+
+	// variable whose storage this instruction takes the address of or accesses directly ("" if none)
+	virtual std::string get_addressed_variable() const;
+	// whether the destination is the pointer base plus a constant number of bytes
+	virtual bool address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const;
 };
 
 // *******************************************
@@ -31,7 +66,9 @@ private:
 public:
 	LabelInstruction(std::string name);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	std::string get_name() const;
 };
 
 class GotoInstruction : public Instruction {
@@ -40,18 +77,56 @@ private:
 public:
 	GotoInstruction(std::string name);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	std::string get_label() const;
 };
 
-class GotoIfEqualInstruction : public Instruction {
+// jumps when "source1 relation source2" holds, relations as in EqualityInstruction;
+// an empty source2 compares against zero
+class GotoIfInstruction : public Instruction {
 private:
 	std::string label_name;
+	std::string source1;
+	std::string source2;
+	ImmediateOperand immediate;
+	char relation;
+public:
+	GotoIfInstruction(std::string name, std::string source1, std::string source2, char relation);
+	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
+	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
+	std::string get_label() const;
+	char get_relation() const;
+	ImmediateOperand const& get_immediate() const;
+	// whether the jump is taken, false if that cannot be worked out
+	bool evaluate_condition(ConstantValues const& known, FunctionStack const& stack, bool& taken) const;
+};
+
+// jumps to the label of the matching case (or the default), either through a
+// table of addresses when the cases are dense or a binary search when they are not
+class SwitchInstruction : public Instruction {
+private:
 	std::string variable;
-	int32_t value;
+	std::map<int32_t, std::string> cases;
+	std::string default_label;
+	bool jump_table;
 public:
-	GotoIfEqualInstruction(std::string name, std::string variable, int32_t value);
+	SwitchInstruction(std::string variable, std::map<int32_t, std::string> const& cases, std::string default_label);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::vector<std::string> get_sources() const;
+	std::string get_variable() const;
+	// label jumped to for a value of the variable
+	std::string get_label(int32_t value) const;
+	// every label the switch can jump to
+	std::vector<std::string> get_labels() const;
+	bool uses_jump_table() const;
 };
 
 // *******************************************
@@ -63,7 +138,10 @@ public:
 	ReturnInstruction();
 	ReturnInstruction(std::string return_variable);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::vector<std::string> get_sources() const;
 };
 
 // *******************************************
@@ -77,7 +155,12 @@ private:
 public:
 	ConstantInstruction(std::string destination, Type type, uint32_t dataLo, uint32_t dataHi = 0);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
 };
 
 class StringInstruction : public Instruction {
@@ -87,7 +170,11 @@ private:
 public:
 	StringInstruction(std::string destination, std::string data);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
 };
 
 // *******************************************
@@ -99,17 +186,39 @@ private:
 public:
 	MoveInstruction(std::string destination, std::string source);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
 };
 
+// stores source through the pointer destination, at a constant byte offset from it;
+// a direct store writes into the variable destination itself
 class AssignInstruction : public Instruction {
 private:
 	std::string destination;
 	std::string source;
+	int32_t offset;
+	bool direct;
+	// type of what is stored, once the address has been folded away from the pointer that had it
+	bool folded;
+	Type target;
 public:
 	AssignInstruction(std::string destination, std::string source);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual std::string get_addressed_variable() const;
+	std::string get_pointer() const;
+	int32_t get_offset() const;
+	// type of what is stored, and its size (0 if the pointer's type does not say)
+	Type stored_type(FunctionStack const& stack) const;
+	unsigned stored_bytes(FunctionStack const& stack) const;
+	void fold_address(std::string base, int32_t offset, bool direct, FunctionStack const& stack);
 };
 
 // *******************************************
@@ -121,17 +230,35 @@ private:
 public:
 	AddressOfInstruction(std::string destination, std::string source);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual std::string get_addressed_variable() const;
+	std::string get_variable() const;
 };
 
+// loads through the pointer source, at a constant byte offset from it;
+// a direct load reads the variable source itself
 class DereferenceInstruction : public Instruction {
 private:
 	std::string destination;
 	std::string source;
+	int32_t offset;
+	bool direct;
 public:
 	DereferenceInstruction(std::string destination, std::string source);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual std::string get_addressed_variable() const;
+	std::string get_pointer() const;
+	int32_t get_offset() const;
+	void fold_address(std::string base, int32_t offset, bool direct);
 };
 
 // *******************************************
@@ -145,7 +272,12 @@ private:
 public:
 	LogicalInstruction(std::string destination, std::string source1, std::string source2, char logicalType);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
 };
 
 class BitwiseInstruction : public Instruction {
@@ -153,11 +285,18 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 	char operatorType;
 public:
 	BitwiseInstruction(std::string destination, std::string source1, std::string source2, char operatorType);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
 };
 
 class EqualityInstruction : public Instruction {
@@ -165,11 +304,18 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 	char equalityType;
 public:
 	EqualityInstruction(std::string destination, std::string source1, std::string source2, char equalityType);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
 };
 
 // *******************************************
@@ -179,11 +325,18 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 	bool doRightShift;
 public:
 	ShiftInstruction(std::string destination, std::string source1, std::string source2, bool doRightShift);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
 };
 
 // *******************************************
@@ -195,7 +348,12 @@ private:
 public:
 	NegativeInstruction(std::string destination, std::string source);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
 };
 
 // *******************************************
@@ -208,7 +366,13 @@ private:
 public:
 	IncrementInstruction(std::string destination, std::string source, bool decrement);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const;
 };
 
 // *******************************************
@@ -218,10 +382,18 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 public:
 	AddInstruction(std::string destination, std::string source1, std::string source2);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
+	virtual bool address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const;
 };
 
 // *******************************************
@@ -231,10 +403,18 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 public:
 	SubInstruction(std::string destination, std::string source1, std::string source2);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
+	virtual bool address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const;
 };
 
 // *******************************************
@@ -244,10 +424,17 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 public:
 	MulInstruction(std::string destination, std::string source1, std::string source2);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
 };
 
 // *******************************************
@@ -257,10 +444,17 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 public:
 	DivInstruction(std::string destination, std::string source1, std::string source2);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
 };
 
 // *******************************************
@@ -270,10 +464,17 @@ private:
 	std::string destination;
 	std::string source1;
 	std::string source2;
+	ImmediateOperand immediate;
 public:
 	ModInstruction(std::string destination, std::string source1, std::string source2);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
+	virtual bool bind_immediate(std::string source, int32_t value, FunctionStack const& stack);
 };
 
 // *******************************************
@@ -286,7 +487,12 @@ private:
 public:
 	CastInstruction(std::string destination, std::string source, Type cast_type);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool evaluate(ConstantValues const& known, FunctionStack const& stack, int32_t& result) const;
 };
 
 // *******************************************
@@ -296,10 +502,21 @@ private:
 	std::string return_result;
 	std::string function_name;
 	std::vector<std::string> arguments;
+	// the caller returns straight after: tear its frame down and jump to the callee
+	bool tail;
 public:
 	FunctionCallInstruction(std::string return_result, std::string function_name, std::vector<std::string> arguments);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	std::string get_function_name() const;
+	std::vector<std::string> get_arguments() const;
+	// bytes the call needs at the bottom of the caller's frame for its arguments
+	unsigned argument_area(IRContext const& context) const;
+	void set_tail();
 };
 
 // *******************************************
@@ -312,7 +529,33 @@ private:
 public:
 	MemberAccessInstruction(std::string destination, std::string base, unsigned offset);
 	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
+	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	virtual bool address_offset(FunctionStack const& stack, std::string& base, int32_t& offset) const;
+};
+
+// *******************************************
+
+// takes the source given for the block control arrived from, by its label; phis
+// sit at the top of a block and only exist while the function is in SSA form
+class PhiInstruction : public Instruction {
+private:
+	std::string destination;
+	std::map<std::string, std::string> incoming;
+public:
+	PhiInstruction(std::string destination);
+	virtual void Debug(std::ostream& dst) const;
+	virtual Instruction* clone() const;
+	virtual void rename(std::map<std::string, std::string> const& names);
 	virtual void PrintMIPS(std::ostream& out, IRContext& context, std::ostream& buff) const;
+	virtual std::string get_destination() const;
+	virtual std::vector<std::string> get_sources() const;
+	// sources by the label of the predecessor they come from
+	std::map<std::string, std::string> const& get_incoming() const;
+	void set_incoming(std::string label, std::string source);
 };
 
 #endif
@@ -0,0 +1,181 @@
+#include "Liveness.hpp"
+
+// *******************************************
+
+static void mark_live(std::map<std::string, LiveRange>& ranges, std::string name, unsigned position) {
+	if(ranges.count(name)) {
+		LiveRange& r = ranges.at(name);
+		if(position < r.start) r.start = position;
+		if(position > r.end) r.end = position;
+	} else {
+		LiveRange r = { position, position };
+		ranges[name] = r;
+	}
+}
+
+static void add_interference(InterferenceGraph& graph, std::string a, std::string b) {
+	if(a == b) return;
+	graph[a].insert(b);
+	graph[b].insert(a);
+}
+
+Liveness::Liveness(ControlFlowGraph const& cfg, FunctionStack const& stack) {
+	unsigned n = cfg.blocks.size();
+
+	// upward-exposed uses and definitions of each block; a phi reads each of its
+	// sources at the end of the predecessor it comes from
+	std::vector<std::set<std::string> > uses(n), defs(n), phi_uses(n);
+	for(unsigned b = 0; b < n; b++) {
+		IRVector const& code = cfg.blocks.at(b).instructions;
+		for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+			if(PhiInstruction* phi = dynamic_cast<PhiInstruction*>(*itr)) {
+				std::map<std::string, std::string> const& incoming = phi->get_incoming();
+				for(std::map<std::string, std::string>::const_iterator s = incoming.begin(); s != incoming.end(); ++s) {
+					int p = cfg.find_block(s->first);
+					if(p >= 0 && stack.count(s->second)) phi_uses.at(p).insert(s->second);
+				}
+			} else {
+				std::vector<std::string> sources = (*itr)->get_sources();
+				for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+					if(stack.count(*s) && !defs.at(b).count(*s)) uses.at(b).insert(*s);
+				}
+			}
+			std::string d = (*itr)->get_destination();
+			if(d != "" && stack.count(d)) defs.at(b).insert(d);
+		}
+	}
+
+	// iterate backwards to a fixed point
+	live_in.assign(n, std::set<std::string>());
+	live_out.assign(n, std::set<std::string>());
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(unsigned i = n; i-- > 0; ) {
+			std::set<std::string> out = phi_uses.at(i);
+			std::vector<unsigned> const& succ = cfg.blocks.at(i).successors;
+			for(std::vector<unsigned>::const_iterator s = succ.begin(); s != succ.end(); ++s) {
+				out.insert(live_in.at(*s).begin(), live_in.at(*s).end());
+			}
+			std::set<std::string> in = uses.at(i);
+			for(std::set<std::string>::const_iterator v = out.begin(); v != out.end(); ++v) {
+				if(!defs.at(i).count(*v)) in.insert(*v);
+			}
+			if(in != live_in.at(i) || out != live_out.at(i)) {
+				live_in.at(i) = in;
+				live_out.at(i) = out;
+				changed = true;
+			}
+		}
+	}
+
+	// walk every block backwards to get ranges and interference
+	unsigned position = 1;
+	for(unsigned b = 0; b < n; b++) {
+		IRVector const& code = cfg.blocks.at(b).instructions;
+		std::set<std::string> live = live_out.at(b);
+		for(unsigned i = code.size(); i-- > 0; ) {
+			unsigned p = position + i;
+			for(std::set<std::string>::const_iterator v = live.begin(); v != live.end(); ++v) {
+				mark_live(ranges, *v, p);
+			}
+			std::vector<std::string> sources;
+			if(!dynamic_cast<PhiInstruction*>(code.at(i))) sources = code.at(i)->get_sources();
+			std::string d = code.at(i)->get_destination();
+			if(d != "" && stack.count(d)) {
+				mark_live(ranges, d, p);
+				// a value written here must not land on top of anything still needed,
+				// nor on an operand the instruction may read after writing
+				for(std::set<std::string>::const_iterator v = live.begin(); v != live.end(); ++v) {
+					add_interference(interference, d, *v);
+				}
+				for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+					if(stack.count(*s)) add_interference(interference, d, *s);
+				}
+				// the phis at the top of a block all write at once
+				if(!dynamic_cast<PhiInstruction*>(code.at(i))) live.erase(d);
+			}
+			for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+				if(stack.count(*s)) {
+					live.insert(*s);
+					mark_live(ranges, *s, p);
+				}
+			}
+		}
+		position += code.size();
+	}
+
+	// everything live on entry (parameters, array pointers) is written by the prologue
+	if(n > 0) {
+		std::set<std::string> const& entry = live_in.at(0);
+		for(std::set<std::string>::const_iterator a = entry.begin(); a != entry.end(); ++a) {
+			mark_live(ranges, *a, 0);
+			for(std::set<std::string>::const_iterator b = entry.begin(); b != entry.end(); ++b) {
+				add_interference(interference, *a, *b);
+			}
+		}
+	}
+}
+
+bool Liveness::interferes(std::string a, std::string b) const {
+	return interference.count(a) && interference.at(a).count(b);
+}
+
+// *******************************************
+
+std::set<std::string> address_taken_variables(IRVector const& code) {
+	std::set<std::string> taken;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		if((*itr)->get_addressed_variable() != "") {
+			taken.insert((*itr)->get_addressed_variable());
+		}
+	}
+	return taken;
+}
+
+// *******************************************
+
+bool memory_access(Instruction const* instruction, FunctionStack const& stack, MemoryRange& range) {
+	if(AssignInstruction const* store = dynamic_cast<AssignInstruction const*>(instruction)) {
+		std::string direct = store->get_addressed_variable();
+		MemoryRange r = { direct != "" ? direct : store->get_pointer(), store->get_offset(), store->stored_bytes(stack), direct != "" };
+		range = r;
+		return true;
+	}
+	if(DereferenceInstruction const* load = dynamic_cast<DereferenceInstruction const*>(instruction)) {
+		std::string direct = load->get_addressed_variable();
+		std::string d = load->get_destination();
+		MemoryRange r = { direct != "" ? direct : load->get_pointer(), load->get_offset(), stack.count(d) ? stack.at(d).bytes() : 0, direct != "" };
+		range = r;
+		return true;
+	}
+	return false;
+}
+
+std::set<std::string> escaped_variables(IRVector const& code) {
+	std::set<std::string> escaped;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		if(AddressOfInstruction* a = dynamic_cast<AddressOfInstruction*>(*itr)) {
+			escaped.insert(a->get_variable());
+		}
+	}
+	return escaped;
+}
+
+static bool overlap(MemoryRange const& a, MemoryRange const& b) {
+	if(a.bytes == 0 || b.bytes == 0) return true;
+	return a.offset < b.offset + (int32_t)b.bytes && b.offset < a.offset + (int32_t)a.bytes;
+}
+
+bool pointer_reachable(FunctionStack const& stack, std::set<std::string> const& escaped, std::string name) {
+	return !stack.count(name) || escaped.count(name);
+}
+
+// stores through the same pointer only meet on the bytes they share; stores through
+// different pointers, or through a pointer to a variable that escaped, may meet anywhere
+bool may_alias(FunctionStack const& stack, std::set<std::string> const& escaped, MemoryRange const& store, MemoryRange const& load) {
+	if(store.direct && load.direct) return store.base == load.base && overlap(store, load);
+	if(store.direct) return pointer_reachable(stack, escaped, store.base);
+	if(load.direct) return pointer_reachable(stack, escaped, load.base);
+	return store.base != load.base || overlap(store, load);
+}
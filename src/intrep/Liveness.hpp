@@ -0,0 +1,59 @@
+#ifndef IR_LIVENESS_H
+#define IR_LIVENESS_H
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "ControlFlowGraph.hpp"
+#include "VariableMap.hpp"
+
+// *******************************************
+
+struct LiveRange {
+	// first and last position (0 = function entry, instruction i = i+1) where the variable is live or written
+	unsigned start;
+	unsigned end;
+};
+
+typedef std::map<std::string, std::set<std::string> > InterferenceGraph;
+
+class Liveness {
+public:
+	// live sets at the boundaries of every block, for the variables in the stack
+	std::vector<std::set<std::string> > live_in;
+	std::vector<std::set<std::string> > live_out;
+
+	std::map<std::string, LiveRange> ranges;
+	// variables that hold values at the same time and so cannot share storage
+	InterferenceGraph interference;
+
+	Liveness(ControlFlowGraph const& cfg, FunctionStack const& stack);
+
+	bool interferes(std::string a, std::string b) const;
+};
+
+// variables whose address escapes into a pointer, liveness cannot see their uses
+std::set<std::string> address_taken_variables(IRVector const& code);
+
+// *******************************************
+
+// bytes at base + offset, where a direct base is a variable rather than a pointer to one
+struct MemoryRange {
+	std::string base;
+	int32_t offset;
+	// 0 when unknown
+	unsigned bytes;
+	bool direct;
+};
+
+// what a load or store touches, false for any other instruction
+bool memory_access(Instruction const* instruction, FunctionStack const& stack, MemoryRange& range);
+// locals whose address is put into a pointer
+std::set<std::string> escaped_variables(IRVector const& code);
+// globals, and locals whose address has been given to a pointer
+bool pointer_reachable(FunctionStack const& stack, std::set<std::string> const& escaped, std::string name);
+// whether a store to one range can change what a load from the other reads
+bool may_alias(FunctionStack const& stack, std::set<std::string> const& escaped, MemoryRange const& store, MemoryRange const& load);
+
+#endif
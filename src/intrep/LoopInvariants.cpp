@@ -0,0 +1,200 @@
+#include "LoopInvariants.hpp"
+
+#include "ControlFlowGraph.hpp"
+#include "Liveness.hpp"
+#include "UniqueNames.hpp"
+
+#include <algorithm>
+
+// *******************************************
+
+// what a loop changes, and what the function lets pointers reach
+struct LoopEffects {
+	FunctionStack const* stack;
+	// locals whose address is put into a pointer
+	std::set<std::string> escaped;
+	// variables the loop writes by name
+	std::set<std::string> defined;
+	std::vector<MemoryRange> stores;
+	bool calls;
+};
+
+static bool memory_unchanged(LoopEffects const& effects, MemoryRange const& load) {
+	if(load.direct && effects.defined.count(load.base)) return false;
+	if(effects.calls && (!load.direct || pointer_reachable(*effects.stack, effects.escaped, load.base))) return false;
+	for(std::vector<MemoryRange>::const_iterator itr = effects.stores.begin(); itr != effects.stores.end(); ++itr) {
+		if(may_alias(*effects.stack, effects.escaped, *itr, load)) return false;
+	}
+	// a write by name to a variable a pointer can reach stores to the whole of it
+	for(std::set<std::string>::const_iterator itr = effects.defined.begin(); itr != effects.defined.end(); ++itr) {
+		if(!pointer_reachable(*effects.stack, effects.escaped, *itr)) continue;
+		MemoryRange whole = { *itr, 0, effects.stack->count(*itr) ? effects.stack->at(*itr).bytes() : 0, true };
+		if(may_alias(*effects.stack, effects.escaped, whole, load)) return false;
+	}
+	return true;
+}
+
+// a variable read by name holds the same value on every iteration
+static bool invariant_variable(LoopEffects const& effects, std::set<std::string> const& address_taken,
+	std::set<std::string> const& hoisted, std::string name) {
+	if(hoisted.count(name)) return true;
+	if(effects.defined.count(name)) return false;
+	if(effects.stack->count(name) && !address_taken.count(name)) return true;
+	// lives in memory: read like a load of the whole variable
+	MemoryRange whole = { name, 0, effects.stack->count(name) ? effects.stack->at(name).bytes() : 0, true };
+	return memory_unchanged(effects, whole);
+}
+
+// computations that only depend on their operands and cannot fault
+static bool is_pure(Instruction const* instruction) {
+	return dynamic_cast<ConstantInstruction const*>(instruction) || dynamic_cast<MoveInstruction const*>(instruction)
+		|| dynamic_cast<AddressOfInstruction const*>(instruction) || dynamic_cast<MemberAccessInstruction const*>(instruction)
+		|| dynamic_cast<LogicalInstruction const*>(instruction) || dynamic_cast<BitwiseInstruction const*>(instruction)
+		|| dynamic_cast<EqualityInstruction const*>(instruction) || dynamic_cast<ShiftInstruction const*>(instruction)
+		|| dynamic_cast<NegativeInstruction const*>(instruction) || dynamic_cast<IncrementInstruction const*>(instruction)
+		|| dynamic_cast<AddInstruction const*>(instruction) || dynamic_cast<SubInstruction const*>(instruction)
+		|| dynamic_cast<MulInstruction const*>(instruction) || dynamic_cast<DivInstruction const*>(instruction)
+		|| dynamic_cast<ModInstruction const*>(instruction) || dynamic_cast<CastInstruction const*>(instruction);
+}
+
+// *******************************************
+
+static bool hoist_from_loop(IRVector& code, FunctionStack const& stack, ControlFlowGraph const& cfg, NaturalLoop const& loop) {
+	if(!cfg.has_preheader_slot(loop)) return false;
+
+	Liveness liveness(cfg, stack);
+	std::set<std::string> address_taken = address_taken_variables(code);
+	std::map<std::string, unsigned> definitions;
+	LoopEffects effects;
+	effects.stack = &stack;
+	effects.escaped = escaped_variables(code);
+	effects.calls = false;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		definitions[(*itr)->get_destination()]++;
+	}
+
+	// exits, and the blocks every iteration that leaves or goes round again passes through
+	std::vector<unsigned> exits;
+	std::set<std::string> live_after;
+	for(std::set<unsigned>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b) {
+		std::vector<unsigned> const& succ = cfg.blocks.at(*b).successors;
+		for(std::vector<unsigned>::const_iterator s = succ.begin(); s != succ.end(); ++s) {
+			if(loop.blocks.count(*s)) continue;
+			exits.push_back(*b);
+			live_after.insert(liveness.live_in.at(*s).begin(), liveness.live_in.at(*s).end());
+		}
+		IRVector const& instructions = cfg.blocks.at(*b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			effects.defined.insert((*itr)->get_destination());
+			if(dynamic_cast<FunctionCallInstruction*>(*itr)) effects.calls = true;
+			MemoryRange range;
+			if(dynamic_cast<AssignInstruction*>(*itr) && memory_access(*itr, stack, range)) {
+				effects.stores.push_back(range);
+			}
+		}
+	}
+	std::set<unsigned> guaranteed;
+	for(std::set<unsigned>::const_iterator b = loop.blocks.begin(); b != loop.blocks.end(); ++b) {
+		bool always = true;
+		for(std::vector<unsigned>::const_iterator e = exits.begin(); e != exits.end(); ++e) {
+			if(!cfg.dominates(*b, *e)) always = false;
+		}
+		for(std::vector<unsigned>::const_iterator l = loop.latches.begin(); l != loop.latches.end(); ++l) {
+			if(!cfg.dominates(*b, *l)) always = false;
+		}
+		if(always) guaranteed.insert(*b);
+	}
+	// pointers certainly dereferenced whenever the loop runs: the rest of the object they
+	// point to can be read early as well
+	std::set<std::string> dereferenced;
+	for(std::set<unsigned>::const_iterator b = guaranteed.begin(); b != guaranteed.end(); ++b) {
+		IRVector const& instructions = cfg.blocks.at(*b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			if(DereferenceInstruction* load = dynamic_cast<DereferenceInstruction*>(*itr)) dereferenced.insert(load->get_pointer());
+			if(AssignInstruction* store = dynamic_cast<AssignInstruction*>(*itr)) dereferenced.insert(store->get_pointer());
+		}
+	}
+
+	std::set<std::string> const& header_live = liveness.live_in.at(loop.header);
+	std::set<std::string> hoisted_names;
+	std::set<Instruction*> moved;
+	IRVector preheader;
+	std::vector<unsigned> order = cfg.reverse_postorder();
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(std::vector<unsigned>::const_iterator b = order.begin(); b != order.end(); ++b) {
+			if(!loop.blocks.count(*b)) continue;
+			IRVector const& instructions = cfg.blocks.at(*b).instructions;
+			for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+				Instruction* instruction = *itr;
+				if(moved.count(instruction)) continue;
+				// a temporary written once, whose old value nothing before or after the loop reads
+				std::string d = instruction->get_destination();
+				if(d == "" || !stack.count(d) || address_taken.count(d) || definitions[d] != 1) continue;
+				if(header_live.count(d) || liveness.live_in.at(0).count(d)) continue;
+				if(live_after.count(d) && !guaranteed.count(*b)) continue;
+
+				DereferenceInstruction* load = dynamic_cast<DereferenceInstruction*>(instruction);
+				if(!load && !is_pure(instruction)) continue;
+				bool invariant = true;
+				std::vector<std::string> sources = instruction->get_sources();
+				for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+					if(!invariant_variable(effects, address_taken, hoisted_names, *s)) invariant = false;
+				}
+				MemoryRange range;
+				if(invariant && memory_access(load, stack, range)) {
+					if(!memory_unchanged(effects, range)) invariant = false;
+					// loading early must not fault where the loop would not have loaded
+					if(!range.direct && !guaranteed.count(*b)) {
+						bool same_object = dereferenced.count(range.base) && stack.count(range.base) && range.offset >= 0
+							&& range.offset + range.bytes <= stack.at(range.base).dereference().bytes();
+						if(!same_object) invariant = false;
+					}
+				}
+				if(!invariant) continue;
+
+				moved.insert(instruction);
+				hoisted_names.insert(d);
+				preheader.push_back(instruction);
+				changed = true;
+			}
+		}
+	}
+	if(preheader.empty()) return false;
+
+	IRVector result;
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		if(b == loop.header) {
+			result.push_back(new LabelInstruction(unique("preheader")));
+			result.insert(result.end(), preheader.begin(), preheader.end());
+		}
+		IRVector const& instructions = cfg.blocks.at(b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			if(!moved.count(*itr)) result.push_back(*itr);
+		}
+	}
+	code = result;
+	return true;
+}
+
+// *******************************************
+
+static bool deeper(NaturalLoop const& a, NaturalLoop const& b) {
+	return a.depth > b.depth;
+}
+
+void hoist_loop_invariants(IRVector& code, FunctionStack& stack) {
+	// innermost loops first, so what they hoist can move further out; every change
+	// reshapes the graph, so start again from a fresh one
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		ControlFlowGraph cfg(code);
+		std::vector<NaturalLoop> loops = cfg.loops;
+		std::stable_sort(loops.begin(), loops.end(), deeper);
+		for(std::vector<NaturalLoop>::const_iterator l = loops.begin(); l != loops.end() && !changed; ++l) {
+			changed = hoist_from_loop(code, stack, cfg, *l);
+		}
+	}
+}
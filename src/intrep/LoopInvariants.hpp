@@ -0,0 +1,11 @@
+#ifndef IR_LOOP_INVARIANTS_H
+#define IR_LOOP_INVARIANTS_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// move computations whose operands do not change inside a loop, and loads no store
+// or call in the loop can overwrite, into a preheader run once before the loop
+void hoist_loop_invariants(IRVector& code, FunctionStack& stack);
+
+#endif
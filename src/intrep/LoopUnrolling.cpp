@@ -0,0 +1,295 @@
+#include "LoopUnrolling.hpp"
+
+#include "AddressFolding.hpp"
+#include "ConstantFolding.hpp"
+#include "ControlFlowGraph.hpp"
+#include "InductionVariables.hpp"
+#include "Liveness.hpp"
+#include "PassManager.hpp"
+#include "UniqueNames.hpp"
+
+#include <algorithm>
+#include <climits>
+
+// *******************************************
+
+/*
+ * "header: if v rel limit goto out; body...; goto header" where the body runs straight
+ * through, changes v by step exactly once, and leaves the limit alone.  A step on a
+ * pointer counts elements.
+ */
+struct CountedLoop {
+	GotoIfInstruction* exit;
+	std::string variable;
+	int32_t step;
+	// "" with a constant limit
+	std::string limit;
+	int32_t constant_limit;
+	IRVector body;
+};
+
+// what one write to the variable adds to it, false if it is not a constant step
+static bool variable_step(IRVector const& body, FunctionStack const& stack, Instruction* write, std::string v, int32_t& step) {
+	std::vector<std::string> sources = write->get_sources();
+	if(sources.size() != 1) return false;
+	if(stack.at(v).is_pointer()) {
+		std::string base;
+		int32_t offset;
+		int32_t size = stack.at(v).dereference().bytes();
+		if(sources.at(0) != v || !write->address_offset(stack, base, offset) || size == 0 || offset % size != 0) return false;
+		step = offset / size;
+		return step != 0;
+	}
+	if(constant_step(write, stack, v, step)) return true;
+	// "t = v + step; move v, t"
+	if(!dynamic_cast<MoveInstruction*>(write)) return false;
+	Instruction* update = NULL;
+	for(IRVector::const_iterator itr = body.begin(); itr != body.end() && *itr != write; ++itr) {
+		if((*itr)->get_destination() == sources.at(0)) update = *itr;
+	}
+	for(IRVector::const_iterator itr = body.begin(); itr != body.end(); ++itr) {
+		if(*itr != update && (*itr)->get_destination() == sources.at(0)) return false;
+	}
+	return update && constant_step(update, stack, v, step);
+}
+
+static bool find_counted_loop(ControlFlowGraph const& cfg, NaturalLoop const& loop, FunctionStack const& stack,
+	std::set<std::string> const& address_taken, CountedLoop& counted) {
+	// header, then the rest of the loop in order, the latch last
+	unsigned h = loop.header;
+	unsigned latch = h + loop.blocks.size() - 1;
+	if(loop.latches.size() != 1 || loop.latches.front() != latch || !loop.blocks.count(latch)) return false;
+	for(unsigned b = h; b <= latch; b++) {
+		if(!loop.blocks.count(b)) return false;
+	}
+	IRVector const& header = cfg.blocks.at(h).instructions;
+	counted.exit = dynamic_cast<GotoIfInstruction*>(header.back());
+	if(header.size() != 2 || !counted.exit || loop.blocks.count(cfg.find_block(counted.exit->get_label()))) return false;
+
+	// straight through back to the header
+	counted.body.clear();
+	for(unsigned b = h + 1; b <= latch; b++) {
+		IRVector const& instructions = cfg.blocks.at(b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			if(b == latch && itr + 1 == instructions.end() && dynamic_cast<GotoInstruction*>(*itr)) break;
+			if(dynamic_cast<LabelInstruction*>(*itr)) continue;
+			if(dynamic_cast<GotoInstruction*>(*itr) || dynamic_cast<GotoIfInstruction*>(*itr)
+				|| dynamic_cast<SwitchInstruction*>(*itr) || dynamic_cast<ReturnInstruction*>(*itr)) return false;
+			counted.body.push_back(*itr);
+		}
+	}
+
+	std::vector<std::string> sources = counted.exit->get_sources();
+	std::string v = sources.at(0);
+	counted.variable = v;
+	if(!stack.count(v) || address_taken.count(v)) return false;
+	bool pointer = stack.at(v).is_pointer();
+	if(!pointer && !(stack.at(v).is_integer() && stack.at(v).is_signed() && stack.at(v).bytes() == 4)) return false;
+
+	Instruction* write = NULL;
+	counted.limit = sources.size() > 1 ? sources.at(1) : "";
+	for(IRVector::const_iterator itr = counted.body.begin(); itr != counted.body.end(); ++itr) {
+		std::string d = (*itr)->get_destination();
+		if(d != "" && d == counted.limit) return false;
+		if(d != v) continue;
+		if(write) return false;
+		write = *itr;
+	}
+	if(!write || !variable_step(counted.body, stack, write, v, counted.step)) return false;
+	char relation = counted.exit->get_relation();
+	bool upwards = counted.step > 0 && (relation == 'g' || relation == '>');
+	bool downwards = counted.step < 0 && (relation == 'l' || relation == '<');
+	if(!upwards && !downwards) return false;
+
+	ImmediateOperand const& immediate = counted.exit->get_immediate();
+	if(counted.limit != "") {
+		if(!stack.count(counted.limit) || address_taken.count(counted.limit)) return false;
+		if(!pointer && !stack.at(counted.limit).is_signed()) return false;
+		return true;
+	}
+	if(pointer || (immediate.bound && !immediate.type.is_signed())) return false;
+	counted.constant_limit = immediate.bound ? immediate.value : 0;
+	return true;
+}
+
+// iterations left, when the variable's value on entry is a constant; false if unknown or over max
+static bool trip_count(ControlFlowGraph const& cfg, NaturalLoop const& loop, FunctionStack const& stack,
+	CountedLoop const& counted, unsigned max, unsigned& trips) {
+	if(counted.limit != "" || loop.header == 0) return false;
+	// the last write before the loop, back through blocks only entered from the one before
+	Instruction* start = NULL;
+	for(unsigned b = loop.header - 1; !start; b--) {
+		IRVector const& before = cfg.blocks.at(b).instructions;
+		for(IRVector::const_reverse_iterator itr = before.rbegin(); itr != before.rend() && !start; ++itr) {
+			if((*itr)->get_destination() == counted.variable) start = *itr;
+		}
+		std::vector<unsigned> const& preds = cfg.blocks.at(b).predecessors;
+		if(!start && (b == 0 || preds.size() != 1 || preds.front() != b - 1)) return false;
+	}
+	int32_t value;
+	if(!dynamic_cast<ConstantInstruction*>(start) || !start->evaluate(ConstantValues(), stack, value)) return false;
+
+	int64_t v = value;
+	int64_t limit = counted.constant_limit;
+	for(trips = 0; trips <= max; trips++) {
+		switch(counted.exit->get_relation()) {
+			case 'g': if(v >= limit) return true; break;
+			case '>': if(v > limit) return true; break;
+			case 'l': if(v <= limit) return true; break;
+			case '<': if(v < limit) return true; break;
+		}
+		v += counted.step;
+		if(v < INT_MIN || v > INT_MAX) return false;
+	}
+	return false;
+}
+
+// each copy gets its own names for what lives within one iteration, so that it can
+// have its own registers
+static void append_copies(IRVector& out, FunctionStack& stack, IRVector const& body, std::set<std::string> const& local,
+	unsigned copies) {
+	for(unsigned c = 0; c < copies; c++) {
+		std::map<std::string, std::string> names;
+		for(std::set<std::string>::const_iterator itr = local.begin(); itr != local.end(); ++itr) {
+			names[*itr] = unique(*itr + "_copy");
+			stack[names.at(*itr)] = stack.at(*itr);
+		}
+		for(IRVector::const_iterator itr = body.begin(); itr != body.end(); ++itr) {
+			Instruction* copy = (*itr)->clone();
+			copy->rename(names);
+			out.push_back(copy);
+		}
+	}
+}
+
+static std::string constant(IRVector& out, FunctionStack& stack, int32_t value) {
+	std::string c = unique("int");
+	stack[c] = Type("int", 0);
+	out.push_back(new ConstantInstruction(c, stack.at(c), value));
+	return c;
+}
+
+// *******************************************
+
+static bool unroll_loop(IRVector& code, FunctionStack& stack, ControlFlowGraph const& cfg, NaturalLoop const& loop,
+	std::set<std::string>& unrolled) {
+	CountedLoop counted;
+	std::set<std::string> address_taken = address_taken_variables(code);
+	if(!cfg.has_preheader_slot(loop) || !find_counted_loop(cfg, loop, stack, address_taken, counted)) return false;
+	unsigned copies = std::min(pass_options().unroll, (unsigned)(UNROLL_BUDGET / std::max((size_t)1, counted.body.size())));
+	std::string header = cfg.blocks.at(loop.header).label;
+	unsigned latch = loop.latches.front();
+	unrolled.insert(header);
+
+	// written in the body, but neither carried into the next iteration nor read after the loop
+	Liveness liveness(cfg, stack);
+	std::set<std::string> const& carried = liveness.live_in.at(loop.header);
+	std::set<std::string> const& after = liveness.live_in.at(cfg.find_block(counted.exit->get_label()));
+	std::set<std::string> local;
+	for(IRVector::const_iterator itr = counted.body.begin(); itr != counted.body.end(); ++itr) {
+		std::string d = (*itr)->get_destination();
+		if(stack.count(d) && !address_taken.count(d) && !carried.count(d) && !after.count(d)) local.insert(d);
+	}
+
+	IRVector result;
+	for(unsigned b = 0; b < loop.header; b++) {
+		result.insert(result.end(), cfg.blocks.at(b).instructions.begin(), cfg.blocks.at(b).instructions.end());
+	}
+
+	unsigned trips;
+	bool known = trip_count(cfg, loop, stack, counted, UNROLL_BUDGET, trips);
+	if(known && trips > copies) {
+		// copies that divide the trip count leave nothing for the loop to finish
+		for(unsigned c = copies; c >= 2; c--) {
+			if(trips % c == 0) {
+				copies = c;
+				break;
+			}
+		}
+	}
+	if(known && trips <= copies) {
+		// straight-line code in place of the loop
+		append_copies(result, stack, counted.body, local, trips);
+		for(unsigned b = loop.header; b <= latch; b++) {
+			IRVector const& instructions = cfg.blocks.at(b).instructions;
+			for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+				delete *itr;
+			}
+		}
+	} else {
+		if(copies < 2) return false;
+		/*
+		 * while v + (copies - 1) * step has not reached the limit, copies iterations are
+		 * left: run them without testing, then let the loop itself do the rest
+		 */
+		bool pointer = stack.at(counted.variable).is_pointer();
+		int64_t ahead = (int64_t)(copies - 1) * counted.step;
+		IRVector preheader;
+		std::string limit = unique("unroll_limit");
+		stack[limit] = pointer ? stack.at(counted.limit) : Type("int", 0);
+		if(counted.limit == "") {
+			int64_t value = counted.constant_limit - ahead;
+			if(value < INT_MIN || value > INT_MAX) return false;
+			preheader.push_back(new ConstantInstruction(limit, stack.at(limit), (int32_t)value));
+		} else {
+			if(!pointer) {
+				// the limit minus the distance must not wrap around
+				int64_t bound = ahead > 0 ? INT_MIN + ahead : INT_MAX + ahead;
+				std::string b = constant(preheader, stack, (int32_t)bound);
+				preheader.push_back(new GotoIfInstruction(header, counted.limit, b, ahead > 0 ? '<' : '>'));
+			}
+			std::string c = constant(preheader, stack, (int32_t)-ahead);
+			AddInstruction* add = new AddInstruction(limit, counted.limit, c);
+			add->bind_immediate(c, (int32_t)-ahead, stack);
+			preheader.push_back(add);
+		}
+
+		std::string main_loop = unique("unroll");
+		unrolled.insert(main_loop);
+		result.push_back(new LabelInstruction(unique("preheader")));
+		result.insert(result.end(), preheader.begin(), preheader.end());
+		result.push_back(new LabelInstruction(main_loop));
+		result.push_back(new GotoIfInstruction(header, counted.variable, limit, counted.exit->get_relation()));
+		append_copies(result, stack, counted.body, local, copies);
+		result.push_back(new GotoInstruction(main_loop));
+		for(unsigned b = loop.header; b <= latch; b++) {
+			result.insert(result.end(), cfg.blocks.at(b).instructions.begin(), cfg.blocks.at(b).instructions.end());
+		}
+	}
+
+	for(unsigned b = latch + 1; b < cfg.blocks.size(); b++) {
+		result.insert(result.end(), cfg.blocks.at(b).instructions.begin(), cfg.blocks.at(b).instructions.end());
+	}
+	code = result;
+	return true;
+}
+
+// *******************************************
+
+static bool deeper(NaturalLoop const& a, NaturalLoop const& b) {
+	return a.depth > b.depth;
+}
+
+void unroll_loops(IRVector& code, FunctionStack& stack) {
+	// the loop left to finish the iterations is not unrolled again
+	std::set<std::string> unrolled;
+	bool changed = true;
+	bool any = false;
+	while(changed) {
+		changed = false;
+		ControlFlowGraph cfg(code);
+		std::vector<NaturalLoop> loops = cfg.loops;
+		std::stable_sort(loops.begin(), loops.end(), deeper);
+		for(std::vector<NaturalLoop>::const_iterator l = loops.begin(); l != loops.end() && !changed; ++l) {
+			if(unrolled.count(cfg.blocks.at(l->header).label)) continue;
+			changed = unroll_loop(code, stack, cfg, *l, unrolled);
+		}
+		any = any || changed;
+	}
+	// in a fully unrolled loop the counter is a constant in every copy
+	if(any) {
+		fold_constants(code, stack);
+		bind_immediates(code, stack);
+		fold_addresses(code, stack);
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef IR_LOOP_UNROLLING_H
+#define IR_LOOP_UNROLLING_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// IR instructions the body of an unrolled loop may grow to
+#define UNROLL_BUDGET 64
+
+/*
+ * Unroll counted loops with a straight-line body: a loop whose trip count is known
+ * and small is replaced by that many copies of its body; any other runs copies of
+ * its body back to back while at least that many iterations are left, and finishes
+ * the last few in the original loop.  At most --unroll copies are made.
+ */
+void unroll_loops(IRVector& code, FunctionStack& stack);
+
+#endif
@@ -0,0 +1,403 @@
+#include "MachineCode.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <sstream>
+
+// *******************************************
+
+int parse_register(std::string operand) {
+	if(operand.size() < 2 || operand[0] != '$') return -1;
+	std::string r = operand.substr(1);
+	if(r == "zero") return 0;
+	if(r == "sp") return 29;
+	if(r == "fp") return 30;
+	if(r == "ra") return 31;
+	unsigned base = 0;
+	if(r[0] == 'f') {
+		base = REG_FP_BASE;
+		r = r.substr(1);
+	}
+	if(r.empty() || r.find_first_not_of("0123456789") != std::string::npos) return -1;
+	int n = atoi(r.c_str());
+	if(n > 31) return -1;
+	return base + n;
+}
+
+std::string register_name(int reg) {
+	std::stringstream ss;
+	if(reg == 29) {
+		ss << "$sp";
+	} else if(reg == 30) {
+		ss << "$fp";
+	} else if(reg >= REG_FP_BASE) {
+		ss << "$f" << (reg - REG_FP_BASE);
+	} else {
+		ss << "$" << reg;
+	}
+	return ss.str();
+}
+
+// base register of a memory operand such as "8($fp)", -1 if there is none
+static int memory_base(std::string operand) {
+	size_t open = operand.rfind('(');
+	size_t close = operand.rfind(')');
+	if(open == std::string::npos || close == std::string::npos || close < open) return -1;
+	return parse_register(operand.substr(open + 1, close - open - 1));
+}
+
+static std::string trim(std::string s) {
+	size_t first = s.find_first_not_of(" \t");
+	if(first == std::string::npos) return "";
+	size_t last = s.find_last_not_of(" \t\r");
+	return s.substr(first, last - first + 1);
+}
+
+static bool has_suffix(std::string const& s, std::string const& suffix) {
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// *******************************************
+
+/*
+ * Role of each operand of an opcode:
+ *   d  register written      D  double FP register pair written
+ *   u  register read         U  double FP register pair read
+ *   m  memory operand (reads its base register)
+ *   l  label    i  immediate
+ * Returns false for opcodes the optimiser does not know about.
+ */
+static bool operand_roles(std::string const& op, std::vector<std::string> const& operands, std::string& roles) {
+	static std::map<std::string, std::string> table;
+	if(table.empty()) {
+		const char* three_reg[] = { "addu", "subu", "add", "sub", "and", "or", "xor", "nor", "slt", "sltu", "sllv", "srlv", "srav", "mul",
+			"add.s", "sub.s", "mul.s", "div.s", 0 };
+		for(unsigned i = 0; three_reg[i]; i++) table[three_reg[i]] = "duu";
+		const char* imm[] = { "addiu", "addi", "andi", "ori", "xori", "slti", "sltiu", "sll", "srl", "sra", 0 };
+		for(unsigned i = 0; imm[i]; i++) table[imm[i]] = "dui";
+		const char* two_reg[] = { "move", "not", "neg", "negu", "mfc1", "mov.s", "neg.s", "abs.s",
+			"cvt.s.w", "cvt.w.s", "trunc.w.s", 0 };
+		for(unsigned i = 0; two_reg[i]; i++) table[two_reg[i]] = "du";
+		const char* loads[] = { "lb", "lbu", "lh", "lhu", "lw", "lwc1", 0 };
+		for(unsigned i = 0; loads[i]; i++) table[loads[i]] = "dm";
+		const char* stores[] = { "sb", "sh", "sw", "swc1", 0 };
+		for(unsigned i = 0; stores[i]; i++) table[stores[i]] = "um";
+		const char* hilo[] = { "mult", "multu", "div", "divu", 0 };
+		for(unsigned i = 0; hilo[i]; i++) table[hilo[i]] = "uu";
+		const char* zero_branch[] = { "beqz", "bnez", "bltz", "bgez", "blez", "bgtz", 0 };
+		for(unsigned i = 0; zero_branch[i]; i++) table[zero_branch[i]] = "ul";
+		table["li"] = "di";
+		table["lui"] = "di";
+		table["la"] = "dl";
+		table["ldc1"] = "Dm";
+		table["sdc1"] = "Um";
+		table["mfhi"] = "d";
+		table["mflo"] = "d";
+		table["mtc1"] = "ud";
+		table["add.d"] = "DUU";
+		table["sub.d"] = "DUU";
+		table["mul.d"] = "DUU";
+		table["div.d"] = "DUU";
+		table["mov.d"] = "DU";
+		table["neg.d"] = "DU";
+		table["abs.d"] = "DU";
+		table["cvt.d.w"] = "Du";
+		table["cvt.d.s"] = "Du";
+		table["cvt.s.d"] = "dU";
+		table["cvt.w.d"] = "dU";
+		table["trunc.w.d"] = "dU";
+		table["beq"] = "uul";
+		table["bne"] = "uul";
+		table["bc1t"] = "l";
+		table["bc1f"] = "l";
+		table["b"] = "l";
+		table["jal"] = "l";
+		table["jr"] = "u";
+		table["jalr"] = "u";
+		table["nop"] = "";
+	}
+	if(op == "j" && operands.size() == 1) {
+		roles = parse_register(operands.at(0)) >= 0 ? "u" : "l";
+		return true;
+	}
+	if(op.compare(0, 2, "c.") == 0) {
+		roles = has_suffix(op, ".d") ? "UU" : "uu";
+		return true;
+	}
+	if(!table.count(op)) return false;
+	roles = table.at(op);
+	return roles.size() == operands.size();
+}
+
+// *******************************************
+
+MachineInstruction::MachineInstruction() : kind(Blank) {}
+
+MachineInstruction::MachineInstruction(std::string opcode) : kind(Instr), opcode(opcode) {}
+
+MachineInstruction::MachineInstruction(std::string opcode, std::string op1, std::string op2, std::string op3)
+: kind(Instr), opcode(opcode) {
+	operands.push_back(op1);
+	if(op2 != "") operands.push_back(op2);
+	if(op3 != "") operands.push_back(op3);
+}
+
+bool MachineInstruction::is(std::string op) const {
+	return kind == Instr && opcode == op;
+}
+
+bool MachineInstruction::is_nop() const {
+	return is("nop");
+}
+
+bool MachineInstruction::is_load() const {
+	return is("lb") || is("lbu") || is("lh") || is("lhu") || is("lw") || is("lwc1") || is("ldc1");
+}
+
+bool MachineInstruction::is_store() const {
+	return is("sb") || is("sh") || is("sw") || is("swc1") || is("sdc1");
+}
+
+bool MachineInstruction::is_conditional_branch() const {
+	if(kind != Instr) return false;
+	return is("beq") || is("bne") || is("beqz") || is("bnez") || is("bltz") || is("bgez")
+		|| is("blez") || is("bgtz") || is("bc1t") || is("bc1f");
+}
+
+bool MachineInstruction::is_call() const {
+	return is("jal") || is("jalr");
+}
+
+bool MachineInstruction::is_unconditional_jump() const {
+	return is("j") || is("jr") || is("b");
+}
+
+bool MachineInstruction::is_return() const {
+	return (is("j") || is("jr")) && operands.size() == 1 && parse_register(operands.at(0)) == 31;
+}
+
+bool MachineInstruction::is_branch() const {
+	return is_conditional_branch() || is_unconditional_jump() || is_call();
+}
+
+std::string MachineInstruction::target() const {
+	if(!is_conditional_branch() && !is("j") && !is("b")) return "";
+	if(operands.empty() || parse_register(operands.back()) >= 0) return "";
+	return operands.back();
+}
+
+// *******************************************
+
+static void add_register(RegisterSet& set, int reg, bool pair) {
+	if(reg < 0) return;
+	set.set(reg);
+	if(pair && reg + 1 < REG_COUNT) set.set(reg + 1);
+}
+
+static RegisterSet all_registers() {
+	RegisterSet all;
+	all.set();
+	return all;
+}
+
+// registers a called function may read or clobber
+static RegisterSet call_uses() {
+	RegisterSet r;
+	for(int i = 4; i <= 7; i++) r.set(i);
+	for(int i = 12; i <= 15; i++) r.set(REG_FP_BASE + i);
+	r.set(29);
+	return r;
+}
+
+static RegisterSet call_defs() {
+	RegisterSet r;
+	r.set(1);
+	for(int i = 2; i <= 15; i++) r.set(i);
+	r.set(24);
+	r.set(25);
+	r.set(31);
+	for(int i = 0; i <= 19; i++) r.set(REG_FP_BASE + i);
+	r.set(REG_HI);
+	r.set(REG_LO);
+	r.set(REG_FCC);
+	return r;
+}
+
+RegisterSet MachineInstruction::uses() const {
+	RegisterSet r;
+	if(kind != Instr) return r;
+	std::string roles;
+	if(!operand_roles(opcode, operands, roles)) return all_registers();
+	for(unsigned i = 0; i < roles.size(); i++) {
+		if(roles[i] == 'u' || roles[i] == 'U') add_register(r, parse_register(operands.at(i)), roles[i] == 'U');
+		if(roles[i] == 'm') add_register(r, memory_base(operands.at(i)), false);
+	}
+	if(is("mfhi")) r.set(REG_HI);
+	if(is("mflo")) r.set(REG_LO);
+	if(is("bc1t") || is("bc1f")) r.set(REG_FCC);
+	if(is_call()) r |= call_uses();
+	r.reset(0);
+	return r;
+}
+
+RegisterSet MachineInstruction::defs() const {
+	RegisterSet r;
+	if(kind != Instr) return r;
+	std::string roles;
+	if(!operand_roles(opcode, operands, roles)) return all_registers();
+	for(unsigned i = 0; i < roles.size(); i++) {
+		if(roles[i] == 'd' || roles[i] == 'D') add_register(r, parse_register(operands.at(i)), roles[i] == 'D');
+	}
+	if(is("mult") || is("multu") || is("div") || is("divu") || is("mul")) {
+		r.set(REG_HI);
+		r.set(REG_LO);
+	}
+	if(opcode.compare(0, 2, "c.") == 0) r.set(REG_FCC);
+	if(is_call()) r |= call_defs();
+	r.reset(0);
+	return r;
+}
+
+bool MachineInstruction::renamable() const {
+	std::string roles;
+	return kind == Instr && !is_call() && operand_roles(opcode, operands, roles);
+}
+
+void MachineInstruction::rename_use(int from, int to) {
+	std::string roles;
+	if(!operand_roles(opcode, operands, roles)) return;
+	for(unsigned i = 0; i < roles.size(); i++) {
+		if(roles[i] == 'u' && parse_register(operands.at(i)) == from) {
+			operands.at(i) = register_name(to);
+		} else if(roles[i] == 'm' && memory_base(operands.at(i)) == from) {
+			std::string& m = operands.at(i);
+			m = m.substr(0, m.rfind('(')) + "(" + register_name(to) + ")";
+		}
+	}
+}
+
+void MachineInstruction::rename_def(int from, int to) {
+	std::string roles;
+	if(!operand_roles(opcode, operands, roles)) return;
+	for(unsigned i = 0; i < roles.size(); i++) {
+		if(roles[i] == 'd' && parse_register(operands.at(i)) == from) {
+			operands.at(i) = register_name(to);
+		}
+	}
+}
+
+// *******************************************
+
+void MachineInstruction::print(std::ostream& out) const {
+	switch(kind) {
+	case Instr:
+		out << "    " << opcode;
+		for(unsigned i = 0; i < operands.size(); i++) {
+			if(i == 0) {
+				out << std::string(opcode.size() < 7 ? 8 - opcode.size() : 1, ' ');
+			} else {
+				out << ", ";
+			}
+			out << operands.at(i);
+		}
+		out << "\n";
+		break;
+	case Label:
+	case Directive:
+		out << text << "\n";
+		break;
+	case Blank:
+		out << "\n";
+		break;
+	}
+}
+
+MachineCode parse_assembly(std::string const& text) {
+	MachineCode code;
+	std::stringstream in(text);
+	std::string line;
+	while(std::getline(in, line)) {
+		std::string t = trim(line);
+		MachineInstruction m;
+		if(t.empty()) {
+			m.kind = MachineInstruction::Blank;
+		} else if(t[0] == '.' || t[0] == '#') {
+			m.kind = MachineInstruction::Directive;
+			m.text = line;
+		} else if(t[t.size() - 1] == ':' && t.find_first_of(" \t") == std::string::npos) {
+			m.kind = MachineInstruction::Label;
+			m.name = t.substr(0, t.size() - 1);
+			m.text = line;
+		} else {
+			m.kind = MachineInstruction::Instr;
+			size_t space = t.find_first_of(" \t");
+			m.opcode = t.substr(0, space);
+			if(space != std::string::npos) {
+				std::stringstream ops(t.substr(space));
+				std::string op;
+				while(std::getline(ops, op, ',')) {
+					m.operands.push_back(trim(op));
+				}
+			}
+		}
+		code.push_back(m);
+	}
+	return code;
+}
+
+void print_assembly(std::ostream& out, MachineCode const& code) {
+	for(MachineCode::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		itr->print(out);
+	}
+}
+
+// *******************************************
+
+std::vector<RegisterSet> live_registers(MachineCode const& code) {
+	// what a caller can see once we return: results, callee-saved and stack registers
+	RegisterSet exit_live;
+	exit_live.set(2);
+	exit_live.set(3);
+	for(int i = 16; i <= 23; i++) exit_live.set(i);
+	exit_live.set(29);
+	exit_live.set(30);
+	exit_live.set(REG_FP_BASE);
+	exit_live.set(REG_FP_BASE + 1);
+
+	std::map<std::string, unsigned> labels;
+	for(unsigned i = 0; i < code.size(); i++) {
+		if(code.at(i).kind == MachineInstruction::Label) labels[code.at(i).name] = i;
+	}
+
+	// live before each instruction, iterated to a fixed point
+	std::vector<RegisterSet> live_in(code.size() + 1);
+	std::vector<RegisterSet> live_out(code.size());
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(unsigned i = code.size(); i-- > 0; ) {
+			MachineInstruction const& m = code.at(i);
+			RegisterSet out;
+			if(m.is_return()) {
+				out = exit_live;
+			} else if(m.kind == MachineInstruction::Instr && (m.is_conditional_branch() || m.is_unconditional_jump())) {
+				std::string t = m.target();
+				if(t == "" || !labels.count(t)) {
+					out = all_registers();
+				} else {
+					out = live_in.at(labels.at(t));
+				}
+				if(m.is_conditional_branch()) out |= live_in.at(i + 1);
+			} else {
+				out = live_in.at(i + 1);
+			}
+			RegisterSet in = (out & ~m.defs()) | m.uses();
+			if(in != live_in.at(i) || out != live_out.at(i)) {
+				live_in.at(i) = in;
+				live_out.at(i) = out;
+				changed = true;
+			}
+		}
+	}
+	return live_out;
+}
@@ -0,0 +1,74 @@
+#ifndef IR_MACHINE_CODE_H
+#define IR_MACHINE_CODE_H
+
+#include <bitset>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// *******************************************
+
+// $0-$31 are 0-31, $f0-$f31 are 32-63, then hi, lo and the FP condition flag
+#define REG_FP_BASE 32
+#define REG_HI 64
+#define REG_LO 65
+#define REG_FCC 66
+#define REG_COUNT 67
+
+typedef std::bitset<REG_COUNT> RegisterSet;
+
+// register number of an operand such as "$8", "$sp" or "$f12", -1 if it is not a register
+int parse_register(std::string operand);
+std::string register_name(int reg);
+
+// *******************************************
+
+struct MachineInstruction {
+	enum Kind { Instr, Label, Directive, Blank };
+
+	Kind kind;
+	std::string opcode;
+	std::vector<std::string> operands;
+	// label name, or the original line of a label or directive
+	std::string name;
+	std::string text;
+
+	MachineInstruction();
+	MachineInstruction(std::string opcode);
+	MachineInstruction(std::string opcode, std::string op1, std::string op2 = "", std::string op3 = "");
+
+	bool is(std::string op) const;
+	bool is_nop() const;
+	bool is_load() const;
+	bool is_store() const;
+	// conditional branches, jumps, calls and returns
+	bool is_branch() const;
+	bool is_conditional_branch() const;
+	bool is_call() const;
+	// control never falls through to the next instruction
+	bool is_unconditional_jump() const;
+	bool is_return() const;
+	// label targeted by a branch or jump ("" if none)
+	std::string target() const;
+
+	RegisterSet uses() const;
+	RegisterSet defs() const;
+	// uses() that come from explicit operands and can be renamed
+	bool renamable() const;
+	// rename register "from" wherever it is read (not written) by this instruction
+	void rename_use(int from, int to);
+	// rename register "from" wherever it is written by this instruction
+	void rename_def(int from, int to);
+
+	void print(std::ostream& out) const;
+};
+
+typedef std::vector<MachineInstruction> MachineCode;
+
+MachineCode parse_assembly(std::string const& text);
+void print_assembly(std::ostream& out, MachineCode const& code);
+
+// registers live after each instruction, worked out over the branches within the function
+std::vector<RegisterSet> live_registers(MachineCode const& code);
+
+#endif
@@ -0,0 +1,163 @@
+#include "PassManager.hpp"
+
+#include "AddressFolding.hpp"
+#include "ConstantFolding.hpp"
+#include "DeadCode.hpp"
+#include "InductionVariables.hpp"
+#include "LoopInvariants.hpp"
+#include "LoopUnrolling.hpp"
+#include "Peephole.hpp"
+#include "RegisterAllocator.hpp"
+#include "ScalarReplacement.hpp"
+#include "Scheduler.hpp"
+#include "StaticSingleAssignment.hpp"
+#include "ValueNumbering.hpp"
+
+#include <iomanip>
+
+// *******************************************
+
+PassOptions::PassOptions() : level(1), time_passes(false), inline_threshold(16), unroll(8), debug(false) {}
+
+PassOptions _pass_options;
+
+PassOptions& pass_options() {
+	return _pass_options;
+}
+
+// *******************************************
+
+PassManager::PassManager() {}
+
+void PassManager::add_pass(std::string name, unsigned level, IRPass pass) {
+	Pass p = { name, level, pass, 0 };
+	passes.push_back(p);
+}
+
+void PassManager::add_pass(std::string name, unsigned level, MachinePass pass) {
+	Pass p = { name, level, 0, pass };
+	passes.push_back(p);
+}
+
+void PassManager::add_pass(std::string name, unsigned level) {
+	Pass p = { name, level, 0, 0 };
+	passes.push_back(p);
+}
+
+PassManager::Pass const* PassManager::find(std::string name) const {
+	for(std::vector<Pass>::const_iterator itr = passes.begin(); itr != passes.end(); ++itr) {
+		if(itr->name == name) return &*itr;
+	}
+	return 0;
+}
+
+bool PassManager::has_pass(std::string name) const {
+	return find(name) != 0;
+}
+
+bool PassManager::enabled(std::string name) const {
+	Pass const* p = find(name);
+	return p && p->level <= pass_options().level;
+}
+
+void PassManager::run(std::string function_name, IRVector& code, FunctionStack& stack) const {
+	for(std::vector<Pass>::const_iterator itr = passes.begin(); itr != passes.end(); ++itr) {
+		if(!itr->ir || itr->level > pass_options().level) continue;
+		{
+			PassTimer timer(itr->name);
+			itr->ir(code, stack);
+		}
+		print_after(itr->name, function_name, code);
+	}
+}
+
+void PassManager::run(std::string function_name, MachineCode& code) const {
+	for(std::vector<Pass>::const_iterator itr = passes.begin(); itr != passes.end(); ++itr) {
+		if(!itr->machine || itr->level > pass_options().level) continue;
+		{
+			PassTimer timer(itr->name);
+			itr->machine(code);
+		}
+		print_after(itr->name, function_name, code);
+	}
+}
+
+void PassManager::print_after(std::string name, std::string function_name, IRVector const& code) const {
+	if(pass_options().print_after != name) return;
+	std::cerr << "# IR of " << function_name << " after " << name << std::endl;
+	for(IRVector::const_iterator i = code.begin(); i != code.end(); ++i) {
+		(*i)->Debug(std::cerr);
+	}
+	std::cerr << std::endl;
+}
+
+void PassManager::print_after(std::string name, std::string function_name, MachineCode const& code) const {
+	if(pass_options().print_after != name) return;
+	std::cerr << "# assembly of " << function_name << " after " << name << std::endl;
+	print_assembly(std::cerr, code);
+}
+
+void PassManager::print_passes(std::ostream& dst) const {
+	for(std::vector<Pass>::const_iterator itr = passes.begin(); itr != passes.end(); ++itr) {
+		dst << "    " << std::left << std::setw(20) << itr->name << "-O" << itr->level << "\n";
+	}
+}
+
+// *******************************************
+
+static void peephole_pass(MachineCode& code) {
+	peephole_optimise(code, peephole_statistics());
+}
+
+static void schedule_pass(MachineCode& code) {
+	schedule_delay_slots(code, target_isa());
+}
+
+static PassManager default_pipeline() {
+	PassManager pm;
+	pm.add_pass("inline", 1);
+	pm.add_pass("tail-calls", 1);
+	pm.add_pass("forward-assignments", 1, forward_variable_assignments);
+	pm.add_pass("constant-fold", 1, fold_constants);
+	pm.add_pass("immediates", 1, bind_immediates);
+	pm.add_pass("fold-addresses", 1, fold_addresses);
+	pm.add_pass("sroa", 1, split_local_structs);
+	pm.add_pass("licm", 1, hoist_loop_invariants);
+	pm.add_pass("strength-reduce", 1, reduce_induction_variables);
+	pm.add_pass("unroll", 2, unroll_loops);
+	pm.add_pass("ssa", 2, build_ssa);
+	pm.add_pass("local-cse", 1, number_values_locally);
+	pm.add_pass("gvn", 2, number_values_globally);
+	pm.add_pass("out-of-ssa", 2, leave_ssa);
+	pm.add_pass("dead-code", 1, eliminate_dead_code);
+	pm.add_pass("regalloc", 1);
+	pm.add_pass("frame-elision", 1);
+	pm.add_pass("peephole", 1, peephole_pass);
+	pm.add_pass("schedule", 1, schedule_pass);
+	return pm;
+}
+
+PassManager const& pass_manager() {
+	static PassManager pm = default_pipeline();
+	return pm;
+}
+
+// *******************************************
+
+std::map<std::string, clock_t> _pass_times;
+
+PassTimer::PassTimer(std::string name) : name(name), start(clock()) {}
+
+PassTimer::~PassTimer() {
+	_pass_times[name] += clock() - start;
+}
+
+void print_pass_timings(std::ostream& dst) {
+	clock_t total = 0;
+	for(std::map<std::string, clock_t>::const_iterator itr = _pass_times.begin(); itr != _pass_times.end(); ++itr) {
+		dst << "# pass " << itr->first << ": " << std::fixed << std::setprecision(3)
+			<< (1000.0 * itr->second / CLOCKS_PER_SEC) << " ms" << std::endl;
+		total += itr->second;
+	}
+	dst << "# pass total: " << std::fixed << std::setprecision(3) << (1000.0 * total / CLOCKS_PER_SEC) << " ms" << std::endl;
+}
@@ -0,0 +1,91 @@
+#ifndef IR_PASS_MANAGER_H
+#define IR_PASS_MANAGER_H
+
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Instruction.hpp"
+#include "MachineCode.hpp"
+#include "VariableMap.hpp"
+
+// *******************************************
+
+struct PassOptions {
+	// -O0, -O1 or -O2
+	unsigned level;
+	// --print-after=<pass>: dump the function to stderr after this pass runs
+	std::string print_after;
+	// --time-passes: report the time spent in each pass
+	bool time_passes;
+	// --inline-threshold=<n>: largest callee, in IR instructions, inlined at every call
+	unsigned inline_threshold;
+	// --unroll=<n>: most copies of a loop body the unroller makes
+	unsigned unroll;
+	// -d, --debug: also describe each frame's layout on stderr
+	bool debug;
+
+	PassOptions();
+};
+
+PassOptions& pass_options();
+
+typedef void (*IRPass)(IRVector& code, FunctionStack& stack);
+typedef void (*MachinePass)(MachineCode& code);
+
+/*
+ * Runs the optimisation pipeline: IR passes over a function once make_instructions
+ * has lowered it, machine passes over its assembly before it is printed.  Steps the
+ * code generator performs itself (e.g. register allocation) are registered without a
+ * function so the level still controls them and they show up in the timings.
+ */
+class PassManager {
+	struct Pass {
+		std::string name;
+		unsigned level;
+		IRPass ir;
+		MachinePass machine;
+	};
+	std::vector<Pass> passes;
+
+	Pass const* find(std::string name) const;
+
+public:
+	PassManager();
+
+	void add_pass(std::string name, unsigned level, IRPass pass);
+	void add_pass(std::string name, unsigned level, MachinePass pass);
+	void add_pass(std::string name, unsigned level);
+
+	bool has_pass(std::string name) const;
+	// registered and switched on by the optimisation level
+	bool enabled(std::string name) const;
+
+	void run(std::string function_name, IRVector& code, FunctionStack& stack) const;
+	void run(std::string function_name, MachineCode& code) const;
+	// --print-after for passes the code generator runs itself, called where they finish
+	void print_after(std::string name, std::string function_name, IRVector const& code) const;
+	void print_after(std::string name, std::string function_name, MachineCode const& code) const;
+
+	void print_passes(std::ostream& dst) const;
+};
+
+// the pipeline used for every function
+PassManager const& pass_manager();
+
+// *******************************************
+
+// charges the time until it goes out of scope to a pass
+class PassTimer {
+	std::string name;
+	clock_t start;
+public:
+	PassTimer(std::string name);
+	~PassTimer();
+};
+
+void print_pass_timings(std::ostream& dst);
+
+#endif
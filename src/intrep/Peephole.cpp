@@ -0,0 +1,205 @@
+#include "Peephole.hpp"
+
+// *******************************************
+
+// next instruction in the same block, optionally skipping nops; -1 at a label or the end
+static int next_instruction(MachineCode const& code, std::vector<bool> const& removed, unsigned i, bool skip_nops) {
+	for(unsigned j = i + 1; j < code.size(); j++) {
+		if(removed.at(j)) continue;
+		MachineInstruction const& m = code.at(j);
+		if(m.kind == MachineInstruction::Label) return -1;
+		if(m.kind != MachineInstruction::Instr) continue;
+		if(skip_nops && m.is_nop()) continue;
+		return j;
+	}
+	return -1;
+}
+
+static int previous_instruction(MachineCode const& code, std::vector<bool> const& removed, unsigned i) {
+	for(unsigned j = i; j-- > 0; ) {
+		if(removed.at(j)) continue;
+		MachineInstruction const& m = code.at(j);
+		if(m.kind == MachineInstruction::Label) return -1;
+		if(m.kind == MachineInstruction::Instr) return j;
+	}
+	return -1;
+}
+
+// instructions the existing code generator follows with a nop for the hazard after them
+static bool wants_nop_after(MachineInstruction const& m) {
+	return m.is_load() || m.is_branch()
+		|| m.is("mfhi") || m.is("mflo") || m.is("mult") || m.is("multu") || m.is("div") || m.is("divu")
+		|| m.is("mtc1") || m.is("mfc1") || m.opcode.compare(0, 2, "c.") == 0;
+}
+
+static bool same_register(std::string a, std::string b) {
+	return parse_register(a) >= 0 && parse_register(a) == parse_register(b);
+}
+
+// one pass over the code, returns whether anything changed
+static bool peephole_sweep(MachineCode& code, PeepholeStats& stats) {
+	std::vector<RegisterSet> live = live_registers(code);
+	std::vector<bool> removed(code.size(), false);
+	bool changed = false;
+
+	for(unsigned i = 0; i < code.size(); i++) {
+		if(removed.at(i) || code.at(i).kind != MachineInstruction::Instr) continue;
+		MachineInstruction& m = code.at(i);
+
+		// move $a, $a
+		if(m.is("move") && same_register(m.operands.at(0), m.operands.at(1))) {
+			removed.at(i) = true;
+			stats["self-move"]++;
+			changed = true;
+			continue;
+		}
+
+		// nops after nops, and nops after instructions that have no hazard
+		if(m.is_nop()) {
+			int p = previous_instruction(code, removed, i);
+			if(p != -1 && code.at(p).is_nop()) {
+				removed.at(i) = true;
+				stats["double-nop"]++;
+				changed = true;
+			} else if(p == -1 || !wants_nop_after(code.at(p))) {
+				removed.at(i) = true;
+				stats["stray-nop"]++;
+				changed = true;
+			}
+			continue;
+		}
+
+		// j L; nop; L:
+		if(m.is("j") && m.target() != "") {
+			bool found = false;
+			for(unsigned j = i + 1; j < code.size(); j++) {
+				if(removed.at(j)) continue;
+				MachineInstruction const& n = code.at(j);
+				if(n.kind == MachineInstruction::Label) {
+					if(n.name == m.target()) {
+						found = true;
+						break;
+					}
+				} else if(n.kind == MachineInstruction::Instr && !n.is_nop()) {
+					break;
+				}
+			}
+			if(found) {
+				for(unsigned j = i; j < code.size() && code.at(j).kind != MachineInstruction::Label; j++) {
+					if(!removed.at(j) && code.at(j).kind == MachineInstruction::Instr) {
+						removed.at(j) = true;
+						stats["jump-to-next"]++;
+					}
+				}
+				changed = true;
+				continue;
+			}
+		}
+
+		// nothing after an unconditional jump (and its nop) runs until the next label
+		if(m.is_unconditional_jump()) {
+			bool delay = true;
+			for(unsigned j = i + 1; j < code.size() && code.at(j).kind != MachineInstruction::Label; j++) {
+				if(removed.at(j) || code.at(j).kind != MachineInstruction::Instr) continue;
+				if(delay && code.at(j).is_nop()) {
+					delay = false;
+					continue;
+				}
+				delay = false;
+				removed.at(j) = true;
+				stats["unreachable"]++;
+				changed = true;
+			}
+			continue;
+		}
+
+		// sw $r, X; lw $s, X
+		if(m.is("sw")) {
+			int j = next_instruction(code, removed, i, true);
+			if(j != -1 && code.at(j).is("lw") && code.at(j).operands.at(1) == m.operands.at(1)) {
+				if(same_register(code.at(j).operands.at(0), m.operands.at(0))) {
+					removed.at(j) = true;
+					stats["store-load"]++;
+				} else {
+					code.at(j) = MachineInstruction("move", code.at(j).operands.at(0), m.operands.at(0));
+				}
+				changed = true;
+				i = j;
+				continue;
+			}
+		}
+
+		// move $a, $b; op ..$a.. => op ..$b..
+		if(m.is("move")) {
+			int a = parse_register(m.operands.at(0));
+			int b = parse_register(m.operands.at(1));
+			int j = next_instruction(code, removed, i, true);
+			if(a > 0 && a < REG_FP_BASE && b >= 0 && j != -1 && code.at(j).renamable() && code.at(j).uses().test(a)
+					&& (!live.at(j).test(a) || code.at(j).defs().test(a))) {
+				MachineInstruction renamed = code.at(j);
+				renamed.rename_use(a, b);
+				if(!renamed.uses().test(a)) {
+					code.at(j) = renamed;
+					removed.at(i) = true;
+					stats["copy-forward"]++;
+					changed = true;
+					i = j;
+					continue;
+				}
+			}
+		}
+
+		// op $a, ...; move $b, $a => op $b, ...
+		if(m.renamable() && !m.is_branch() && m.defs().count() == 1) {
+			int j = next_instruction(code, removed, i, true);
+			if(j != -1 && code.at(j).is("move")) {
+				int a = parse_register(code.at(j).operands.at(1));
+				int b = parse_register(code.at(j).operands.at(0));
+				if(a > 0 && b > 0 && a != b && m.defs().test(a) && !live.at(j).test(a)) {
+					m.rename_def(a, b);
+					removed.at(j) = true;
+					stats["copy-back"]++;
+					changed = true;
+					i = j;
+					continue;
+				}
+			}
+		}
+
+		// results nobody reads
+		if(m.renamable() && !m.is_branch() && !m.is_store() && m.defs().any() && (m.defs() & live.at(i)).none()) {
+			removed.at(i) = true;
+			stats["dead-code"]++;
+			changed = true;
+			continue;
+		}
+	}
+
+	MachineCode result;
+	for(unsigned i = 0; i < code.size(); i++) {
+		if(!removed.at(i)) result.push_back(code.at(i));
+	}
+	code = result;
+	return changed;
+}
+
+void peephole_optimise(MachineCode& code, PeepholeStats& stats) {
+	while(peephole_sweep(code, stats));
+}
+
+// *******************************************
+
+PeepholeStats _peephole_statistics;
+
+PeepholeStats& peephole_statistics() {
+	return _peephole_statistics;
+}
+
+void print_peephole_statistics(std::ostream& dst) {
+	unsigned total = 0;
+	for(PeepholeStats::const_iterator itr = _peephole_statistics.begin(); itr != _peephole_statistics.end(); ++itr) {
+		dst << "# peephole " << itr->first << ": " << itr->second << " removed" << std::endl;
+		total += itr->second;
+	}
+	dst << "# peephole total: " << total << " removed" << std::endl;
+}
@@ -0,0 +1,20 @@
+#ifndef IR_PEEPHOLE_H
+#define IR_PEEPHOLE_H
+
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "MachineCode.hpp"
+
+// instructions removed by each rule
+typedef std::map<std::string, unsigned> PeepholeStats;
+
+// rewrite a function's machine code until no rule applies
+void peephole_optimise(MachineCode& code, PeepholeStats& stats);
+
+// totals over everything compiled so far
+PeepholeStats& peephole_statistics();
+void print_peephole_statistics(std::ostream& dst);
+
+#endif
@@ -0,0 +1,157 @@
+#include "RegisterAllocator.hpp"
+
+#include <algorithm>
+#include <set>
+
+// *******************************************
+
+void forward_variable_assignments(IRVector& code, FunctionStack& stack) {
+	// count how every name is defined and used
+	std::map<std::string, unsigned> definitions;
+	std::map<std::string, unsigned> uses;
+	std::map<std::string, unsigned> pointer_uses;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		if((*itr)->get_destination() != "") {
+			definitions[(*itr)->get_destination()]++;
+		}
+		std::vector<std::string> sources = (*itr)->get_sources();
+		for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+			uses[*s]++;
+		}
+		if(AssignInstruction* a = dynamic_cast<AssignInstruction*>(*itr)) {
+			if(a->get_pointer() != "") pointer_uses[a->get_pointer()]++;
+		}
+	}
+
+	// find addresses that are only ever written through
+	std::map<std::string, std::string> forwarded;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		if(AddressOfInstruction* a = dynamic_cast<AddressOfInstruction*>(*itr)) {
+			std::string t = a->get_destination();
+			if(stack.count(t) && definitions[t] == 1 && uses[t] == pointer_uses[t]) {
+				forwarded[t] = a->get_variable();
+			}
+		}
+	}
+
+	// rewrite the code
+	IRVector result;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		AssignInstruction* store = dynamic_cast<AssignInstruction*>(*itr);
+		if(dynamic_cast<AddressOfInstruction*>(*itr) && forwarded.count((*itr)->get_destination())) {
+			delete *itr;
+		} else if(store && forwarded.count(store->get_pointer())) {
+			// the value stored is the last source
+			std::vector<std::string> sources = store->get_sources();
+			result.push_back(new MoveInstruction(forwarded.at(store->get_pointer()), sources.back()));
+			delete *itr;
+		} else {
+			result.push_back(*itr);
+		}
+	}
+	code = result;
+
+	for(std::map<std::string, std::string>::const_iterator itr = forwarded.begin(); itr != forwarded.end(); ++itr) {
+		stack.erase(itr->first);
+	}
+}
+
+// *******************************************
+
+struct LiveInterval {
+	std::string name;
+	unsigned start;
+	unsigned end;
+
+	bool operator<(LiveInterval const& other) const {
+		if(start != other.start) return start < other.start;
+		return name < other.name;
+	}
+};
+
+static bool can_allocate(std::string name,
+	FunctionStack const& stack,
+	VariableMap const& globals,
+	std::set<std::string> const& address_taken)
+	{
+	if(!stack.count(name) || globals.count(name) || address_taken.count(name)) {
+		return false;
+	}
+	Type t = stack.at(name);
+	return !t.is_struct() && t.builtin_type != Type::Void && t.bytes() <= 4;
+}
+
+std::map<std::string, unsigned> allocate_registers(Liveness const& liveness,
+	FunctionStack const& stack,
+	VariableMap const& globals,
+	std::set<std::string> const& address_taken,
+	bool leaf,
+	std::map<std::string, unsigned> const& hints)
+	{
+	// linear scan
+	std::vector<LiveInterval> ordered;
+	for(std::map<std::string, LiveRange>::const_iterator itr = liveness.ranges.begin(); itr != liveness.ranges.end(); ++itr) {
+		if(can_allocate(itr->first, stack, globals, address_taken)) {
+			LiveInterval interval = { itr->first, itr->second.start, itr->second.end };
+			ordered.push_back(interval);
+		}
+	}
+	std::sort(ordered.begin(), ordered.end());
+
+	std::map<std::string, unsigned> allocation;
+	std::vector<LiveInterval> active;
+	std::set<unsigned> free_registers;
+	for(unsigned r = FIRST_SAVED_REGISTER; r <= LAST_SAVED_REGISTER; r++) {
+		free_registers.insert(r);
+	}
+	if(leaf) {
+		for(unsigned r = FIRST_ARGUMENT_REGISTER; r <= LAST_ARGUMENT_REGISTER; r++) {
+			free_registers.insert(r);
+		}
+	}
+	// hinted registers still wanted by an interval that has not been allocated yet
+	std::map<unsigned, unsigned> pending_hints;
+	for(std::vector<LiveInterval>::const_iterator itr = ordered.begin(); itr != ordered.end(); ++itr) {
+		if(hints.count(itr->name)) pending_hints[hints.at(itr->name)]++;
+	}
+	for(std::vector<LiveInterval>::const_iterator current = ordered.begin(); current != ordered.end(); ++current) {
+		// release registers whose intervals finished before this one starts
+		for(std::vector<LiveInterval>::iterator a = active.begin(); a != active.end(); ) {
+			if(a->end < current->start) {
+				free_registers.insert(allocation.at(a->name));
+				a = active.erase(a);
+			} else {
+				++a;
+			}
+		}
+		std::set<unsigned>::iterator choice = free_registers.end();
+		if(hints.count(current->name)) {
+			pending_hints[hints.at(current->name)]--;
+			choice = free_registers.find(hints.at(current->name));
+		}
+		for(std::set<unsigned>::iterator r = free_registers.begin(); choice == free_registers.end() && r != free_registers.end(); ++r) {
+			if(!pending_hints[*r]) choice = r;
+		}
+		if(choice == free_registers.end()) {
+			choice = free_registers.begin();
+		}
+		if(choice != free_registers.end()) {
+			allocation[current->name] = *choice;
+			free_registers.erase(choice);
+			active.push_back(*current);
+		} else {
+			// out of registers: spill whichever interval ends last
+			std::vector<LiveInterval>::iterator furthest = active.begin();
+			for(std::vector<LiveInterval>::iterator a = active.begin(); a != active.end(); ++a) {
+				if(a->end > furthest->end) furthest = a;
+			}
+			if(furthest->end > current->end) {
+				allocation[current->name] = allocation.at(furthest->name);
+				allocation.erase(furthest->name);
+				active.erase(furthest);
+				active.push_back(*current);
+			}
+		}
+	}
+	return allocation;
+}
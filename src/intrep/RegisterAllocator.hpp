@@ -0,0 +1,34 @@
+#ifndef IR_REGISTER_ALLOCATOR_H
+#define IR_REGISTER_ALLOCATOR_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Instruction.hpp"
+#include "Liveness.hpp"
+#include "VariableMap.hpp"
+
+// registers handed out to variables: the callee-saved $16-$23, and in a leaf
+// function also the argument registers $4-$7, which no call can clobber there
+// ($2, $3, $8-$15 and $24/$25 are scratch for the instruction printers)
+#define FIRST_SAVED_REGISTER 16
+#define LAST_SAVED_REGISTER 23
+#define FIRST_ARGUMENT_REGISTER 4
+#define LAST_ARGUMENT_REGISTER 7
+
+// replace "addressOf t, &v; assign *t, s" with "move v, s" so that locals
+// which never have their address taken stop looking address-taken
+void forward_variable_assignments(IRVector& code, FunctionStack& stack);
+
+// linear scan over live ranges, returns the register of each allocated variable;
+// a variable gets its hinted register (e.g. the one a parameter arrives in) when free
+std::map<std::string, unsigned> allocate_registers(Liveness const& liveness,
+	FunctionStack const& stack,
+	VariableMap const& globals,
+	std::set<std::string> const& address_taken,
+	bool leaf,
+	std::map<std::string, unsigned> const& hints);
+
+#endif
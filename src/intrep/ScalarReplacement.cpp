@@ -0,0 +1,236 @@
+#include "ScalarReplacement.hpp"
+
+#include "ConstantFolding.hpp"
+#include "ControlFlowGraph.hpp"
+#include "DeadCode.hpp"
+#include "Liveness.hpp"
+#include "UniqueNames.hpp"
+
+// *******************************************
+
+// a member of a split struct, and the variable that now holds it
+struct Member {
+	std::string variable;
+	Type type;
+	int32_t offset;
+};
+
+typedef std::map<std::string, std::vector<Member> > SplitStructs;
+
+// the members of a local struct that can be split, false if it cannot
+static bool struct_members(FunctionStack const& stack, std::string name, std::vector<Member>& members) {
+	Type type = stack.at(name);
+	if(!type.is_struct() || type.is_pointer() || stack.arrays.count(name)) return false;
+	// the members of a union overlap
+	if(type.name().substr(0, 6) == "union ") return false;
+	StructureMap all = structures();
+	if(!all.count(type.struct_name())) return false;
+	StructureType const& s = all.at(type.struct_name());
+	if(!s.arrays.empty() || s.order.empty() || s.order.size() > SPLIT_STRUCT_MEMBERS) return false;
+
+	for(std::vector<std::string>::const_iterator itr = s.order.begin(); itr != s.order.end(); ++itr) {
+		Type member = s.get_member_type(*itr);
+		if(member.is_struct() && !member.is_pointer()) return false;
+		if(member.bytes() == 0 || member.bytes() > 4) return false;
+		Member m = { name + "_" + *itr, member, (int32_t)s.get_member_offset(*itr) };
+		members.push_back(m);
+	}
+	return true;
+}
+
+// the member a load or store of type at offset reads or writes, 0 if it is not exactly one
+static Member const* find_member(std::vector<Member> const& members, int32_t offset, Type type) {
+	for(std::vector<Member>::const_iterator itr = members.begin(); itr != members.end(); ++itr) {
+		if(itr->offset == offset && itr->type.equals(type)) return &*itr;
+	}
+	return 0;
+}
+
+static bool is_struct_copy(Instruction const* instruction, FunctionStack const& stack) {
+	if(!dynamic_cast<MoveInstruction const*>(instruction)) return false;
+	std::string d = instruction->get_destination();
+	std::string s = instruction->get_sources().at(0);
+	return stack.count(d) && stack.count(s) && stack.at(d).is_struct() && !stack.at(d).is_pointer()
+		&& stack.at(d).equals(stack.at(s));
+}
+
+// *******************************************
+
+/*
+ * Keep the structs only read and written member by member, or copied whole to each
+ * other, and where the struct has to be in memory as a whole no more often than its
+ * members are used.
+ */
+static void choose_structs(IRVector const& code, FunctionStack const& stack, SplitStructs& split) {
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		std::set<std::string> unsplittable;
+		std::map<std::string, unsigned> accesses;
+		// where the whole struct is read from or written to memory
+		std::map<std::string, unsigned> spills;
+
+		for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+			Instruction const* instruction = *itr;
+			std::string base = instruction->get_addressed_variable();
+			if(split.count(base)) {
+				Member const* member = 0;
+				if(DereferenceInstruction const* load = dynamic_cast<DereferenceInstruction const*>(instruction)) {
+					member = find_member(split.at(base), load->get_offset(), stack.at(load->get_destination()));
+				} else if(AssignInstruction const* store = dynamic_cast<AssignInstruction const*>(instruction)) {
+					member = find_member(split.at(base), store->get_offset(), store->stored_type(stack));
+				}
+				// the address escapes, or the access covers part of a member or several
+				if(member) {
+					accesses[base]++;
+				} else {
+					unsplittable.insert(base);
+				}
+			}
+
+			std::string d = instruction->get_destination();
+			std::vector<std::string> sources = instruction->get_sources();
+			if(is_struct_copy(instruction, stack) && split.count(d) && split.count(sources.at(0))) {
+				accesses[d] += split.at(d).size();
+				accesses[sources.at(0)] += split.at(d).size();
+				continue;
+			}
+			for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+				if(split.count(*s)) spills[*s]++;
+			}
+			if(split.count(d)) spills[d]++;
+		}
+
+		for(SplitStructs::iterator itr = split.begin(); itr != split.end(); ) {
+			std::string name = itr->first;
+			if(unsplittable.count(name) || accesses[name] == 0 || spills[name] * itr->second.size() > accesses[name]) {
+				split.erase(itr++);
+				changed = true;
+			} else {
+				++itr;
+			}
+		}
+	}
+}
+
+// *******************************************
+
+static Instruction* load_member(std::string base, Member const& member) {
+	DereferenceInstruction* load = new DereferenceInstruction(member.variable, base);
+	load->fold_address(base, member.offset, true);
+	return load;
+}
+
+static Instruction* store_member(FunctionStack& stack, std::string base, Member const& member, std::string source) {
+	// a folded store takes the type it writes from the pointer it started with
+	std::string pointer = unique("member_addr");
+	stack[pointer] = member.type.addressof();
+	AssignInstruction* store = new AssignInstruction(pointer, source);
+	store->fold_address(base, member.offset, true, stack);
+	stack.erase(pointer);
+	return store;
+}
+
+static void rewrite(IRVector& code, FunctionStack& stack, SplitStructs const& split) {
+	IRVector result;
+	for(IRVector::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		Instruction* instruction = *itr;
+		std::string base = instruction->get_addressed_variable();
+		std::string d = instruction->get_destination();
+		std::vector<std::string> sources = instruction->get_sources();
+
+		if(split.count(base)) {
+			if(DereferenceInstruction* load = dynamic_cast<DereferenceInstruction*>(instruction)) {
+				Member const* member = find_member(split.at(base), load->get_offset(), stack.at(d));
+				result.push_back(new MoveInstruction(d, member->variable));
+			} else {
+				AssignInstruction* store = dynamic_cast<AssignInstruction*>(instruction);
+				Member const* member = find_member(split.at(base), store->get_offset(), store->stored_type(stack));
+				result.push_back(new MoveInstruction(member->variable, sources.back()));
+			}
+			delete instruction;
+			continue;
+		}
+
+		if(is_struct_copy(instruction, stack) && (split.count(d) || split.count(sources.at(0)))) {
+			std::string s = sources.at(0);
+			std::vector<Member> const& members = split.count(d) ? split.at(d) : split.at(s);
+			for(unsigned m = 0; m < members.size(); m++) {
+				if(split.count(d) && split.count(s)) {
+					result.push_back(new MoveInstruction(split.at(d).at(m).variable, split.at(s).at(m).variable));
+				} else if(split.count(d)) {
+					result.push_back(load_member(s, members.at(m)));
+				} else {
+					result.push_back(store_member(stack, d, members.at(m), members.at(m).variable));
+				}
+			}
+			delete instruction;
+			continue;
+		}
+
+		// anything else sees the struct in memory
+		std::set<std::string> stored;
+		for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+			if(!split.count(*s) || !stored.insert(*s).second) continue;
+			std::vector<Member> const& members = split.at(*s);
+			for(std::vector<Member>::const_iterator m = members.begin(); m != members.end(); ++m) {
+				result.push_back(store_member(stack, *s, *m, m->variable));
+			}
+		}
+		result.push_back(instruction);
+		if(split.count(d)) {
+			std::vector<Member> const& members = split.at(d);
+			for(std::vector<Member>::const_iterator m = members.begin(); m != members.end(); ++m) {
+				result.push_back(load_member(d, *m));
+			}
+		}
+	}
+	code = result;
+
+	// members read before anything writes them start out as what the struct holds on
+	// entry, which for a parameter is the argument
+	ControlFlowGraph cfg(code);
+	Liveness liveness(cfg, stack);
+	IRVector entry;
+	for(SplitStructs::const_iterator itr = split.begin(); itr != split.end(); ++itr) {
+		for(std::vector<Member>::const_iterator m = itr->second.begin(); m != itr->second.end(); ++m) {
+			if(liveness.live_in.at(0).count(m->variable)) entry.push_back(load_member(itr->first, *m));
+		}
+	}
+	code.insert(code.begin(), entry.begin(), entry.end());
+}
+
+// *******************************************
+
+void split_local_structs(IRVector& code, FunctionStack& stack) {
+	SplitStructs split;
+	for(FunctionStack::const_iterator itr = stack.begin(); itr != stack.end(); ++itr) {
+		std::vector<Member> members;
+		if(struct_members(stack, itr->first, members)) split[itr->first] = members;
+	}
+	if(split.empty()) return;
+
+	// the addresses member accesses were worked out from are still there, unused
+	eliminate_dead_code(code, stack);
+	for(SplitStructs::iterator itr = split.begin(); itr != split.end(); ) {
+		if(stack.count(itr->first)) {
+			++itr;
+		} else {
+			split.erase(itr++);
+		}
+	}
+	choose_structs(code, stack, split);
+	if(split.empty()) return;
+
+	for(SplitStructs::iterator itr = split.begin(); itr != split.end(); ++itr) {
+		for(std::vector<Member>::iterator m = itr->second.begin(); m != itr->second.end(); ++m) {
+			m->variable = unique(m->variable);
+			stack[m->variable] = m->type;
+		}
+	}
+	rewrite(code, stack, split);
+
+	// constant members now fold like any other variable
+	fold_constants(code, stack);
+	bind_immediates(code, stack);
+}
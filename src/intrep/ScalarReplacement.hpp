@@ -0,0 +1,19 @@
+#ifndef IR_SCALAR_REPLACEMENT_H
+#define IR_SCALAR_REPLACEMENT_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// members a struct may have and still be split into variables
+#define SPLIT_STRUCT_MEMBERS 4
+
+/*
+ * Split small local structs whose address never escapes into one variable per member,
+ * which the register allocator can then keep in registers.  Member loads and stores
+ * become moves and struct copies copy member by member; where the struct itself is
+ * needed in memory (a call argument, a return value, a copy to or from a struct that
+ * stays whole) its members are stored back first or loaded again afterwards.
+ */
+void split_local_structs(IRVector& code, FunctionStack& stack);
+
+#endif
@@ -0,0 +1,292 @@
+#include "Scheduler.hpp"
+
+#include <cstdlib>
+
+// *******************************************
+
+TargetISA _target_isa = TARGET_MIPS1;
+
+TargetISA& target_isa() {
+	return _target_isa;
+}
+
+// *******************************************
+
+// an instruction together with the directives (e.g. ".option pic0") that must stay in front of it
+struct ScheduleNode {
+	MachineInstruction instruction;
+	std::vector<MachineInstruction> directives;
+};
+
+static bool is_hilo_read(MachineInstruction const& m) {
+	return m.is("mfhi") || m.is("mflo");
+}
+
+static bool is_hilo_write(MachineInstruction const& m) {
+	return m.is("mult") || m.is("multu") || m.is("div") || m.is("divu") || m.is("mul");
+}
+
+static bool is_coprocessor_move(MachineInstruction const& m) {
+	return m.is("mtc1") || m.is("mfc1");
+}
+
+static bool is_fp_compare(MachineInstruction const& m) {
+	return m.kind == MachineInstruction::Instr && m.opcode.compare(0, 2, "c.") == 0;
+}
+
+// la is a load from the GOT once the assembler expands it
+static bool is_delayed_load(MachineInstruction const& m) {
+	return m.is_load() || m.is("la");
+}
+
+// cycles that must pass after m before anything may see its result (MIPS I only)
+static unsigned hazard_distance(MachineInstruction const& m, TargetISA target) {
+	if(target != TARGET_MIPS1) return 1;
+	// mul is mult + mflo on MIPS I
+	if(is_hilo_read(m) || m.is("mul")) return 3;
+	if(is_delayed_load(m) || is_coprocessor_move(m) || is_fp_compare(m)) return 2;
+	return 1;
+}
+
+// memory operand "offset(base)" of a load or store
+static bool memory_operand(MachineInstruction const& m, int& base, long& offset, unsigned& size) {
+	if(!m.is_load() && !m.is_store()) return false;
+	std::string op = m.operands.back();
+	size_t open = op.rfind('(');
+	base = -1;
+	offset = 0;
+	if(open != std::string::npos && op[op.size() - 1] == ')') {
+		base = parse_register(op.substr(open + 1, op.size() - open - 2));
+		std::string off = op.substr(0, open);
+		char* end = 0;
+		offset = strtol(off.c_str(), &end, 10);
+		if(off.empty() || *end != '\0') base = -1;
+	}
+	if(m.is("lb") || m.is("lbu") || m.is("sb")) size = 1;
+	else if(m.is("lh") || m.is("lhu") || m.is("sh")) size = 2;
+	else if(m.is("ldc1") || m.is("sdc1")) size = 8;
+	else size = 4;
+	return true;
+}
+
+static bool memory_conflict(MachineInstruction const& a, MachineInstruction const& b) {
+	int base_a, base_b;
+	long offset_a, offset_b;
+	unsigned size_a, size_b;
+	if(!memory_operand(a, base_a, offset_a, size_a) || !memory_operand(b, base_b, offset_b, size_b)) return false;
+	if(!a.is_store() && !b.is_store()) return false;
+	// same base register: only overlapping bytes conflict
+	if(base_a >= 0 && base_a == base_b) {
+		return offset_a < offset_b + (long)size_b && offset_b < offset_a + (long)size_a;
+	}
+	return true;
+}
+
+// minimum distance in cycles from a to a later instruction b, 0 if b does not depend on a
+static unsigned dependence_latency(MachineInstruction const& a, MachineInstruction const& b, TargetISA target) {
+	unsigned latency = 0;
+	RegisterSet a_defs = a.defs(), a_uses = a.uses();
+	RegisterSet b_defs = b.defs(), b_uses = b.uses();
+	if((a_defs & b_uses).any()) {
+		// a call's arguments are not read until after its delay slot
+		bool delayed = is_delayed_load(a) || is_coprocessor_move(a) || is_fp_compare(a);
+		latency = (target == TARGET_MIPS1 && delayed && !b.is_call()) ? 2 : 1;
+	}
+	if((a_defs & b_defs).any()) {
+		// a delayed load lands after the next instruction and would overwrite it
+		unsigned waw = (target == TARGET_MIPS1 && is_delayed_load(a)) ? 2 : 1;
+		if(waw > latency) latency = waw;
+	}
+	if((a_uses & b_defs).any()) {
+		// MIPS I corrupts hi/lo if they are rewritten within two instructions of being read
+		unsigned war = (target == TARGET_MIPS1 && (is_hilo_read(a) || a.is("mul")) && is_hilo_write(b)) ? 3 : 1;
+		if(war > latency) latency = war;
+	}
+	if(latency == 0 && memory_conflict(a, b)) latency = 1;
+	return latency;
+}
+
+// can m execute in the delay slot of a branch: one real instruction without hazards of its own
+static bool fits_delay_slot(MachineInstruction const& m, TargetISA target) {
+	if(m.kind != MachineInstruction::Instr || m.is_branch() || m.is_nop() || !m.renamable()) return false;
+	if(m.is("la")) return false;
+	if(m.is("li") && m.operands.size() == 2) {
+		long value = strtol(m.operands.at(1).c_str(), 0, 0);
+		if(value < -32768 || value > 65535) return false;
+	}
+	int base;
+	long offset;
+	unsigned size;
+	if(memory_operand(m, base, offset, size) && base < 0) return false;
+	if(target == TARGET_MIPS1 && hazard_distance(m, target) > 1) return false;
+	return true;
+}
+
+// *******************************************
+
+static void emit(MachineCode& out, ScheduleNode const& node) {
+	out.insert(out.end(), node.directives.begin(), node.directives.end());
+	out.push_back(node.instruction);
+}
+
+/*
+ * List-schedule one straight-line region: body instructions, optionally ending
+ * in a branch.  Nodes are picked by the longest latency-weighted path to the end
+ * of the region, nops are only emitted when nothing is ready, and the region is
+ * padded so no hazard is left pending for whatever runs next.
+ */
+static void schedule_region(MachineCode& out, std::vector<ScheduleNode> const& region, TargetISA target) {
+	if(region.empty()) return;
+	unsigned n = region.size();
+	bool has_branch = region.back().instruction.is_branch();
+	unsigned body = has_branch ? n - 1 : n;
+
+	// latency[i][j] for i < j, 0 if independent
+	std::vector<std::vector<unsigned> > latency(n, std::vector<unsigned>(n, 0));
+	for(unsigned i = 0; i < n; i++) {
+		for(unsigned j = i + 1; j < n; j++) {
+			latency.at(i).at(j) = dependence_latency(region.at(i).instruction, region.at(j).instruction, target);
+		}
+	}
+
+	// pick the delay slot filler: the last body instruction nothing else waits for
+	int filler = -1;
+	if(has_branch) {
+		MachineInstruction const& branch = region.back().instruction;
+		for(unsigned i = body; i-- > 0; ) {
+			MachineInstruction const& m = region.at(i).instruction;
+			bool free = fits_delay_slot(m, target);
+			for(unsigned j = i + 1; free && j < body; j++) {
+				if(latency.at(i).at(j)) free = false;
+			}
+			if(free && latency.at(i).at(body)) {
+				// a call writes $31 before its delay slot runs, everything else it clobbers later
+				RegisterSet blocking = m.defs() & branch.uses();
+				if(!branch.is_call()) blocking |= m.uses() & branch.defs();
+				if(m.uses().test(31) || m.defs().test(31) || blocking.any()) free = false;
+			}
+			if(free) {
+				filler = i;
+				break;
+			}
+		}
+	}
+
+	// latency-weighted height of every node
+	std::vector<unsigned> height(n, 0);
+	for(unsigned i = n; i-- > 0; ) {
+		height.at(i) = hazard_distance(region.at(i).instruction, target);
+		for(unsigned j = i + 1; j < n; j++) {
+			unsigned l = latency.at(i).at(j);
+			if(l && l + height.at(j) > height.at(i)) height.at(i) = l + height.at(j);
+		}
+	}
+
+	std::vector<int> cycle(n, -1);
+	unsigned now = 0;
+	unsigned remaining = body - (filler >= 0 ? 1 : 0);
+	while(remaining > 0) {
+		int best = -1;
+		for(unsigned j = 0; j < body; j++) {
+			if(cycle.at(j) >= 0 || (int)j == filler) continue;
+			bool ready = true;
+			for(unsigned i = 0; ready && i < j; i++) {
+				unsigned l = latency.at(i).at(j);
+				if(l && (cycle.at(i) < 0 || (unsigned)cycle.at(i) + l > now)) ready = false;
+			}
+			if(ready && (best < 0 || height.at(j) > height.at(best))) best = j;
+		}
+		if(best < 0) {
+			out.push_back(MachineInstruction("nop"));
+		} else {
+			emit(out, region.at(best));
+			cycle.at(best) = now;
+			remaining--;
+		}
+		now++;
+	}
+
+	if(has_branch) {
+		// the branch waits for its own operands and for whatever the filler depends on
+		unsigned earliest = now;
+		for(unsigned i = 0; i < body; i++) {
+			if(cycle.at(i) < 0) continue;
+			if(latency.at(i).at(body) && cycle.at(i) + latency.at(i).at(body) > earliest) {
+				earliest = cycle.at(i) + latency.at(i).at(body);
+			}
+			if(filler >= 0 && latency.at(i).at(filler) && cycle.at(i) + latency.at(i).at(filler) > earliest + 1) {
+				earliest = cycle.at(i) + latency.at(i).at(filler) - 1;
+			}
+		}
+		for(; now < earliest; now++) {
+			out.push_back(MachineInstruction("nop"));
+		}
+		emit(out, region.at(body));
+		cycle.at(body) = now++;
+		if(filler >= 0) {
+			emit(out, region.at(filler));
+			cycle.at(filler) = now;
+		} else {
+			out.push_back(MachineInstruction("nop"));
+		}
+		now++;
+	}
+
+	// leave no hazard open across the end of the region
+	unsigned end = now;
+	for(unsigned i = 0; i < n; i++) {
+		if(cycle.at(i) >= 0 && cycle.at(i) + hazard_distance(region.at(i).instruction, target) > end) {
+			end = cycle.at(i) + hazard_distance(region.at(i).instruction, target);
+		}
+	}
+	for(; now < end; now++) {
+		out.push_back(MachineInstruction("nop"));
+	}
+}
+
+void schedule_delay_slots(MachineCode& code, TargetISA target) {
+	MachineCode out;
+	MachineInstruction noreorder;
+	noreorder.kind = MachineInstruction::Directive;
+	noreorder.text = "    .set    noreorder";
+	out.push_back(noreorder);
+
+	std::vector<ScheduleNode> region;
+	std::vector<MachineInstruction> directives;
+	for(MachineCode::const_iterator itr = code.begin(); itr != code.end(); ++itr) {
+		MachineInstruction const& m = *itr;
+		if(m.kind == MachineInstruction::Directive) {
+			// directives inside a region travel with the instruction after them
+			if(region.empty()) {
+				out.push_back(m);
+			} else {
+				directives.push_back(m);
+			}
+		} else if(m.kind == MachineInstruction::Instr) {
+			// nops are put back wherever the new order needs them
+			if(m.is_nop()) continue;
+			ScheduleNode node;
+			node.instruction = m;
+			node.directives.swap(directives);
+			region.push_back(node);
+			if(m.is_branch()) {
+				schedule_region(out, region, target);
+				region.clear();
+			}
+		} else {
+			schedule_region(out, region, target);
+			region.clear();
+			out.insert(out.end(), directives.begin(), directives.end());
+			directives.clear();
+			out.push_back(m);
+		}
+	}
+	schedule_region(out, region, target);
+	out.insert(out.end(), directives.begin(), directives.end());
+
+	MachineInstruction reorder;
+	reorder.kind = MachineInstruction::Directive;
+	reorder.text = "    .set    reorder";
+	out.push_back(reorder);
+	code.swap(out);
+}
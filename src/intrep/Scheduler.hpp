@@ -0,0 +1,20 @@
+#ifndef IR_SCHEDULER_H
+#define IR_SCHEDULER_H
+
+#include "MachineCode.hpp"
+
+enum TargetISA {
+	// loads, coprocessor moves and hi/lo reads have delay slots the code must respect
+	TARGET_MIPS1,
+	// the pipeline interlocks, only branch delay slots remain
+	TARGET_MIPS32
+};
+
+// processor the generated code is scheduled for
+TargetISA& target_isa();
+
+// reorder each block to fill load and branch delay slots, falling back to nops
+// where nothing independent is available; the result is wrapped in .set noreorder
+void schedule_delay_slots(MachineCode& code, TargetISA target);
+
+#endif
@@ -0,0 +1,75 @@
+#include "StackSlots.hpp"
+
+#include <algorithm>
+
+// *******************************************
+
+struct StackSlot {
+	unsigned bytes;
+	std::vector<std::string> occupants;
+	// holds an address-taken variable, which nothing else may share
+	bool exclusive;
+};
+
+struct LargestFirst {
+	FunctionStack const& stack;
+	LargestFirst(FunctionStack const& stack) : stack(stack) {}
+	bool operator()(std::string const& a, std::string const& b) const {
+		if(stack.at(a).bytes() != stack.at(b).bytes()) return stack.at(a).bytes() > stack.at(b).bytes();
+		return a < b;
+	}
+};
+
+unsigned allocate_stack_slots(std::vector<std::string> const& variables,
+	FunctionStack const& stack,
+	Liveness const& liveness,
+	std::set<std::string> const& address_taken,
+	unsigned base,
+	std::map<std::string, unsigned>& offsets)
+	{
+	// greedy colouring of the interference graph, largest variables first so every
+	// slot is sized and aligned by its first occupant
+	std::vector<std::string> ordered = variables;
+	std::sort(ordered.begin(), ordered.end(), LargestFirst(stack));
+
+	std::vector<StackSlot> slots;
+	std::map<std::string, unsigned> slot_of;
+	for(std::vector<std::string>::const_iterator v = ordered.begin(); v != ordered.end(); ++v) {
+		bool exclusive = address_taken.count(*v);
+		unsigned chosen = slots.size();
+		for(unsigned i = 0; i < slots.size() && !exclusive; i++) {
+			StackSlot const& slot = slots.at(i);
+			if(slot.exclusive || slot.bytes < stack.at(*v).bytes()) continue;
+			bool conflict = false;
+			for(std::vector<std::string>::const_iterator o = slot.occupants.begin(); o != slot.occupants.end(); ++o) {
+				if(liveness.interferes(*v, *o)) {
+					conflict = true;
+					break;
+				}
+			}
+			if(!conflict) {
+				chosen = i;
+				break;
+			}
+		}
+		if(chosen == slots.size()) {
+			StackSlot slot = { stack.at(*v).bytes(), std::vector<std::string>(), exclusive };
+			slots.push_back(slot);
+		}
+		slots.at(chosen).occupants.push_back(*v);
+		slot_of[*v] = chosen;
+	}
+
+	// lay the slots out
+	std::vector<unsigned> slot_offsets;
+	unsigned end = base;
+	for(std::vector<StackSlot>::const_iterator slot = slots.begin(); slot != slots.end(); ++slot) {
+		align_address(end, slot->bytes);
+		slot_offsets.push_back(end);
+		end += slot->bytes;
+	}
+	for(std::map<std::string, unsigned>::const_iterator itr = slot_of.begin(); itr != slot_of.end(); ++itr) {
+		offsets[itr->first] = slot_offsets.at(itr->second);
+	}
+	return end;
+}
@@ -0,0 +1,21 @@
+#ifndef IR_STACK_SLOTS_H
+#define IR_STACK_SLOTS_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Liveness.hpp"
+#include "VariableMap.hpp"
+
+// lay out the variables in the frame from offset base, letting variables whose
+// lifetimes never overlap share a slot; returns the offset just past the last slot
+unsigned allocate_stack_slots(std::vector<std::string> const& variables,
+	FunctionStack const& stack,
+	Liveness const& liveness,
+	std::set<std::string> const& address_taken,
+	unsigned base,
+	std::map<std::string, unsigned>& offsets);
+
+#endif
@@ -0,0 +1,299 @@
+#include "StaticSingleAssignment.hpp"
+
+#include "ControlFlowGraph.hpp"
+#include "Liveness.hpp"
+#include "UniqueNames.hpp"
+
+#include <algorithm>
+
+// *******************************************
+
+// the blocks where paths through a block meet paths that do not pass through it
+static std::vector<std::set<unsigned> > dominance_frontiers(ControlFlowGraph const& cfg) {
+	std::vector<std::set<unsigned> > frontiers(cfg.blocks.size());
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		std::vector<unsigned> const& preds = cfg.blocks.at(b).predecessors;
+		if(!cfg.is_reachable(b) || preds.size() < 2) continue;
+		for(std::vector<unsigned>::const_iterator p = preds.begin(); p != preds.end(); ++p) {
+			if(!cfg.is_reachable(*p)) continue;
+			for(int runner = *p; runner != cfg.immediate_dominator(b); runner = cfg.immediate_dominator(runner)) {
+				frontiers.at(runner).insert(b);
+			}
+		}
+	}
+	return frontiers;
+}
+
+// a local only ever read and written by name
+static bool promotable(FunctionStack const& stack, std::set<std::string> const& address_taken, std::string name) {
+	if(!stack.count(name) || stack.arrays.count(name) || address_taken.count(name)) return false;
+	return !stack.at(name).is_struct();
+}
+
+struct Renaming {
+	ControlFlowGraph* cfg;
+	FunctionStack* stack;
+	std::vector<std::vector<unsigned> > children;
+	std::set<std::string> promoted;
+	// locals that get a phi at the top of each block, the variable it writes and
+	// what it reads from each predecessor
+	std::vector<std::vector<std::string> > phis;
+	std::vector<std::map<std::string, std::string> > phi_names;
+	std::vector<std::map<std::string, std::map<std::string, std::string> > > phi_incoming;
+	// names in use for each local, the latest last
+	std::map<std::string, std::vector<std::string> > current;
+};
+
+static std::string current_name(Renaming const& r, std::string variable) {
+	std::map<std::string, std::vector<std::string> >::const_iterator itr = r.current.find(variable);
+	if(itr == r.current.end() || itr->second.empty()) return variable;
+	return itr->second.back();
+}
+
+static std::string new_name(Renaming& r, std::string variable) {
+	std::string name = unique(variable + "_");
+	(*r.stack)[name] = r.stack->at(variable);
+	r.current[variable].push_back(name);
+	return name;
+}
+
+// down the dominator tree, so every read sees the name of the write that reaches it
+static void rename_block(Renaming& r, unsigned b) {
+	std::vector<std::string> written;
+	std::vector<std::string> const& phis = r.phis.at(b);
+	for(std::vector<std::string>::const_iterator v = phis.begin(); v != phis.end(); ++v) {
+		r.phi_names.at(b)[*v] = new_name(r, *v);
+		written.push_back(*v);
+	}
+
+	IRVector& instructions = r.cfg->blocks.at(b).instructions;
+	for(IRVector::iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+		std::map<std::string, std::string> names;
+		std::vector<std::string> sources = (*itr)->get_sources();
+		for(std::vector<std::string>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+			if(r.promoted.count(*s)) names[*s] = current_name(r, *s);
+		}
+		std::string d = (*itr)->get_destination();
+		if(r.promoted.count(d)) {
+			names[d] = new_name(r, d);
+			written.push_back(d);
+		}
+		if(!names.empty()) (*itr)->rename(names);
+	}
+
+	std::string label = r.cfg->blocks.at(b).label;
+	std::vector<unsigned> const& succ = r.cfg->blocks.at(b).successors;
+	for(std::vector<unsigned>::const_iterator s = succ.begin(); s != succ.end(); ++s) {
+		std::vector<std::string> const& meeting = r.phis.at(*s);
+		for(std::vector<std::string>::const_iterator v = meeting.begin(); v != meeting.end(); ++v) {
+			r.phi_incoming.at(*s)[*v][label] = current_name(r, *v);
+		}
+	}
+
+	std::vector<unsigned> const& below = r.children.at(b);
+	for(std::vector<unsigned>::const_iterator c = below.begin(); c != below.end(); ++c) {
+		rename_block(r, *c);
+	}
+	for(std::vector<std::string>::const_iterator w = written.begin(); w != written.end(); ++w) {
+		r.current[*w].pop_back();
+	}
+}
+
+void build_ssa(IRVector& code, FunctionStack& stack) {
+	ControlFlowGraph cfg(code);
+	Liveness liveness(cfg, stack);
+	std::set<std::string> address_taken = address_taken_variables(code);
+	std::vector<std::set<unsigned> > frontiers = dominance_frontiers(cfg);
+
+	// the blocks writing each local; one that an instruction both reads and writes is left alone
+	std::map<std::string, std::set<unsigned> > defining_blocks;
+	std::map<std::string, unsigned> writes;
+	std::set<std::string> excluded;
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector const& instructions = cfg.blocks.at(b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			std::string d = (*itr)->get_destination();
+			if(d == "" || !promotable(stack, address_taken, d)) continue;
+			std::vector<std::string> sources = (*itr)->get_sources();
+			if(std::find(sources.begin(), sources.end(), d) != sources.end()) excluded.insert(d);
+			writes[d]++;
+			if(cfg.is_reachable(b)) defining_blocks[d].insert(b);
+		}
+	}
+
+	Renaming r;
+	r.cfg = &cfg;
+	r.stack = &stack;
+	r.children.resize(cfg.blocks.size());
+	r.phis.resize(cfg.blocks.size());
+	r.phi_names.resize(cfg.blocks.size());
+	r.phi_incoming.resize(cfg.blocks.size());
+	for(std::map<std::string, std::set<unsigned> >::const_iterator itr = defining_blocks.begin(); itr != defining_blocks.end(); ++itr) {
+		std::string v = itr->first;
+		if(excluded.count(v) || writes.at(v) < 2) continue;
+		// phis go where writes from different paths meet and the local is still read
+		std::set<unsigned> sites;
+		std::vector<unsigned> work(itr->second.begin(), itr->second.end());
+		while(!work.empty()) {
+			unsigned b = work.back();
+			work.pop_back();
+			for(std::set<unsigned>::const_iterator f = frontiers.at(b).begin(); f != frontiers.at(b).end(); ++f) {
+				if(sites.count(*f) || !liveness.live_in.at(*f).count(v)) continue;
+				sites.insert(*f);
+				work.push_back(*f);
+			}
+		}
+		// the entry has no label for the way in from the caller
+		if(sites.count(0)) continue;
+		r.promoted.insert(v);
+		for(std::set<unsigned>::const_iterator f = sites.begin(); f != sites.end(); ++f) {
+			r.phis.at(*f).push_back(v);
+		}
+	}
+	if(r.promoted.empty()) return;
+
+	// a phi names its predecessors by their labels
+	for(unsigned f = 0; f < cfg.blocks.size(); f++) {
+		if(r.phis.at(f).empty()) continue;
+		std::vector<unsigned> const& preds = cfg.blocks.at(f).predecessors;
+		for(std::vector<unsigned>::const_iterator p = preds.begin(); p != preds.end(); ++p) {
+			BasicBlock& block = cfg.blocks.at(*p);
+			if(block.label != "") continue;
+			block.label = unique("block");
+			block.instructions.insert(block.instructions.begin(), new LabelInstruction(block.label));
+		}
+	}
+
+	for(unsigned b = 1; b < cfg.blocks.size(); b++) {
+		if(cfg.is_reachable(b)) r.children.at(cfg.immediate_dominator(b)).push_back(b);
+	}
+	rename_block(r, 0);
+
+	// predecessors that are never reached pass on the value the local has on entry
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		std::vector<std::string> const& phis = r.phis.at(b);
+		IRVector& instructions = cfg.blocks.at(b).instructions;
+		for(unsigned i = 0; i < phis.size(); i++) {
+			std::string v = phis.at(i);
+			std::map<std::string, std::string> const& incoming = r.phi_incoming.at(b)[v];
+			PhiInstruction* phi = new PhiInstruction(r.phi_names.at(b).at(v));
+			std::vector<unsigned> const& preds = cfg.blocks.at(b).predecessors;
+			for(std::vector<unsigned>::const_iterator p = preds.begin(); p != preds.end(); ++p) {
+				std::string label = cfg.blocks.at(*p).label;
+				phi->set_incoming(label, incoming.count(label) ? incoming.at(label) : v);
+			}
+			instructions.insert(instructions.begin() + 1 + i, phi);
+		}
+	}
+	code = cfg.flatten();
+}
+
+// *******************************************
+
+// variables that will share one name, by the first of them
+typedef std::map<std::string, std::vector<std::string> > Classes;
+
+static std::string class_of(Classes& classes, std::map<std::string, std::string>& owner, std::string name) {
+	if(!owner.count(name)) {
+		owner[name] = name;
+		classes[name].push_back(name);
+	}
+	return owner.at(name);
+}
+
+static bool overlapping(Liveness const& liveness, std::vector<std::string> const& a, std::vector<std::string> const& b) {
+	for(std::vector<std::string>::const_iterator x = a.begin(); x != a.end(); ++x) {
+		for(std::vector<std::string>::const_iterator y = b.begin(); y != b.end(); ++y) {
+			if(liveness.interferes(*x, *y)) return true;
+		}
+	}
+	return false;
+}
+
+// the shortest name in a class is the local the others were split from
+static bool shorter(std::string const& a, std::string const& b) {
+	if(a.size() != b.size()) return a.size() < b.size();
+	return a < b;
+}
+
+void leave_ssa(IRVector& code, FunctionStack& stack) {
+	ControlFlowGraph cfg(code);
+	Liveness liveness(cfg, stack);
+
+	// a phi joins its sources wherever none of their live ranges overlap
+	Classes classes;
+	std::map<std::string, std::string> owner;
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector const& instructions = cfg.blocks.at(b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			PhiInstruction* phi = dynamic_cast<PhiInstruction*>(*itr);
+			if(!phi) continue;
+			std::string x = phi->get_destination();
+			std::map<std::string, std::string> const& incoming = phi->get_incoming();
+			for(std::map<std::string, std::string>::const_iterator s = incoming.begin(); s != incoming.end(); ++s) {
+				std::string a = s->second;
+				if(!stack.count(a) || !stack.at(a).equals(stack.at(x))) continue;
+				std::string cx = class_of(classes, owner, x);
+				std::string ca = class_of(classes, owner, a);
+				if(cx == ca || overlapping(liveness, classes.at(cx), classes.at(ca))) continue;
+				std::vector<std::string> const& moving = classes.at(ca);
+				for(std::vector<std::string>::const_iterator m = moving.begin(); m != moving.end(); ++m) {
+					owner[*m] = cx;
+					classes.at(cx).push_back(*m);
+				}
+				classes.erase(ca);
+			}
+		}
+	}
+	std::map<std::string, std::string> names;
+	for(Classes::const_iterator itr = classes.begin(); itr != classes.end(); ++itr) {
+		std::string name = *std::min_element(itr->second.begin(), itr->second.end(), shorter);
+		for(std::vector<std::string>::const_iterator m = itr->second.begin(); m != itr->second.end(); ++m) {
+			if(*m != name) names[*m] = name;
+		}
+	}
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector const& instructions = cfg.blocks.at(b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			(*itr)->rename(names);
+		}
+	}
+
+	// what is left of a phi becomes copies: each predecessor writes a variable only
+	// the phi's block reads, so a copy made before a branch cannot disturb the other way
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector& instructions = cfg.blocks.at(b).instructions;
+		for(unsigned i = 0; i < instructions.size(); i++) {
+			PhiInstruction* phi = dynamic_cast<PhiInstruction*>(instructions.at(i));
+			if(!phi) continue;
+			std::string x = phi->get_destination();
+			std::map<std::string, std::string> const& incoming = phi->get_incoming();
+			bool same = true;
+			for(std::map<std::string, std::string>::const_iterator s = incoming.begin(); s != incoming.end(); ++s) {
+				if(s->second != x) same = false;
+			}
+			if(same) {
+				delete phi;
+				instructions.erase(instructions.begin() + i);
+				i--;
+				continue;
+			}
+			std::string arrived = unique(x + "_in");
+			stack[arrived] = stack.at(x);
+			for(std::map<std::string, std::string>::const_iterator s = incoming.begin(); s != incoming.end(); ++s) {
+				int p = cfg.find_block(s->first);
+				if(p < 0) continue;
+				IRVector& pred = cfg.blocks.at(p).instructions;
+				Instruction* last = pred.back();
+				IRVector::iterator position = pred.end();
+				if(dynamic_cast<GotoInstruction*>(last) || dynamic_cast<GotoIfInstruction*>(last) || dynamic_cast<SwitchInstruction*>(last)) {
+					--position;
+				}
+				pred.insert(position, new MoveInstruction(arrived, s->second));
+			}
+			instructions.at(i) = new MoveInstruction(x, arrived);
+			delete phi;
+		}
+	}
+	code = cfg.flatten();
+}
@@ -0,0 +1,22 @@
+#ifndef IR_STATIC_SINGLE_ASSIGNMENT_H
+#define IR_STATIC_SINGLE_ASSIGNMENT_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+/*
+ * Give every write to a local whose address is never taken a variable of its own,
+ * with phis where writes from different paths meet, so that each name has a single
+ * definition that dominates its uses.  The value a local has on entry keeps the
+ * local's own name.
+ */
+void build_ssa(IRVector& code, FunctionStack& stack);
+
+/*
+ * Leave SSA form again: a phi and its sources share one variable when their live
+ * ranges do not overlap, and otherwise each predecessor copies its source into a
+ * fresh variable the phi's block then reads.
+ */
+void leave_ssa(IRVector& code, FunctionStack& stack);
+
+#endif
@@ -0,0 +1,84 @@
+#include "TailCalls.hpp"
+
+#include "Liveness.hpp"
+#include "UniqueNames.hpp"
+
+#include <algorithm>
+
+// *******************************************
+
+std::vector<unsigned> tail_calls(IRVector const& code) {
+	std::vector<unsigned> result;
+	for(unsigned i = 0; i < code.size(); i++) {
+		FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(code.at(i));
+		if(!call) continue;
+		// labels in between do not run
+		unsigned next = i + 1;
+		while(next < code.size() && dynamic_cast<LabelInstruction*>(code.at(next))) next++;
+		if(next == code.size()) {
+			result.push_back(i);
+			continue;
+		}
+		ReturnInstruction* r = dynamic_cast<ReturnInstruction*>(code.at(next));
+		if(!r) continue;
+		std::vector<std::string> value = r->get_sources();
+		if(value.empty() || value.at(0) == call->get_destination()) {
+			result.push_back(i);
+		}
+	}
+	return result;
+}
+
+bool frame_reusable(IRVector const& code, FunctionStack const& stack) {
+	if(!stack.arrays.empty()) return false;
+	// globals are written through their address too, those are fine
+	std::set<std::string> address_taken = address_taken_variables(code);
+	for(std::set<std::string>::const_iterator itr = address_taken.begin(); itr != address_taken.end(); ++itr) {
+		if(stack.count(*itr)) return false;
+	}
+	return true;
+}
+
+// *******************************************
+
+void loop_tail_recursion(IRVector& code, FunctionStack& stack, std::string function_name,
+	std::vector<std::string> const& parameters) {
+	if(!frame_reusable(code, stack)) return;
+	std::vector<unsigned> calls = tail_calls(code);
+	std::string top = "";
+
+	// from the back, so the indices still to come stay valid
+	for(unsigned c = calls.size(); c-- > 0; ) {
+		unsigned i = calls.at(c);
+		FunctionCallInstruction* call = dynamic_cast<FunctionCallInstruction*>(code.at(i));
+		std::vector<std::string> arguments = call->get_arguments();
+		if(call->get_function_name() != function_name || arguments.size() != parameters.size()) continue;
+		if(top == "") top = unique("fnc_" + function_name + "_tail");
+
+		// an argument that is another parameter could be overwritten before it is read
+		IRVector loop;
+		for(unsigned p = 0; p < parameters.size(); p++) {
+			std::vector<std::string>::const_iterator other = std::find(parameters.begin(), parameters.end(), arguments.at(p));
+			if(other != parameters.end() && *other != parameters.at(p)) {
+				std::string t = unique("tail_arg");
+				stack[t] = stack.at(arguments.at(p));
+				loop.push_back(new MoveInstruction(t, arguments.at(p)));
+				arguments.at(p) = t;
+			}
+		}
+		for(unsigned p = 0; p < parameters.size(); p++) {
+			if(arguments.at(p) == parameters.at(p)) continue;
+			loop.push_back(new MoveInstruction(parameters.at(p), arguments.at(p)));
+		}
+		loop.push_back(new GotoInstruction(top));
+
+		// the return after the call is left for dead code, it may be shared by other paths
+		delete call;
+		code.erase(code.begin() + i);
+		code.insert(code.begin() + i, loop.begin(), loop.end());
+	}
+
+	if(top != "") {
+		code.insert(code.begin(), new LabelInstruction(top));
+	}
+}
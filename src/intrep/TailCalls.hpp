@@ -0,0 +1,24 @@
+#ifndef IR_TAIL_CALLS_H
+#define IR_TAIL_CALLS_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+// indices of the calls in tail position: nothing runs after them but a return of
+// their result, or a return of nothing
+std::vector<unsigned> tail_calls(IRVector const& code);
+
+// a function that takes the address of none of its variables and has no local arrays keeps
+// nothing in its frame a callee could be pointing at, so the frame can go before one
+bool frame_reusable(IRVector const& code, FunctionStack const& stack);
+
+/*
+ * Turn the function's calls to itself in tail position into a loop: the arguments
+ * are moved into the parameters and control jumps back to the top of the body, just
+ * after the prologue.  Arguments that are other parameters go through temporaries,
+ * as every argument is evaluated before any parameter changes.
+ */
+void loop_tail_recursion(IRVector& code, FunctionStack& stack, std::string function_name,
+	std::vector<std::string> const& parameters);
+
+#endif
@@ -0,0 +1,304 @@
+#include "ValueNumbering.hpp"
+
+#include "ControlFlowGraph.hpp"
+#include "Liveness.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+// *******************************************
+
+// a value already worked out: the variable holding it and what it was worked out from
+struct Available {
+	std::string holder;
+	std::vector<std::string> sources;
+	// a load, and the memory it read
+	bool load;
+	MemoryRange range;
+	// holds the same value in every block the one computing it dominates
+	bool lasting;
+};
+
+// by the operation and its operands
+typedef std::map<std::string, Available> ValueTable;
+
+// what pointers can reach in the function, and what it writes
+struct FunctionFacts {
+	FunctionStack const* stack;
+	ControlFlowGraph const* cfg;
+	std::set<std::string> address_taken;
+	std::set<std::string> escaped;
+	std::map<std::string, unsigned> definitions;
+	// block writing each variable that is written once
+	std::map<std::string, unsigned> defining_block;
+	std::vector<MemoryRange> stores;
+	bool calls;
+	bool global;
+};
+
+// operations worth reading back rather than repeating: loads, and everything that
+// only depends on its operands except constants and copies
+static bool reusable(Instruction const* instruction) {
+	return dynamic_cast<DereferenceInstruction const*>(instruction)
+		|| dynamic_cast<AddressOfInstruction const*>(instruction) || dynamic_cast<MemberAccessInstruction const*>(instruction)
+		|| dynamic_cast<LogicalInstruction const*>(instruction) || dynamic_cast<BitwiseInstruction const*>(instruction)
+		|| dynamic_cast<EqualityInstruction const*>(instruction) || dynamic_cast<ShiftInstruction const*>(instruction)
+		|| dynamic_cast<NegativeInstruction const*>(instruction) || dynamic_cast<IncrementInstruction const*>(instruction)
+		|| dynamic_cast<AddInstruction const*>(instruction) || dynamic_cast<SubInstruction const*>(instruction)
+		|| dynamic_cast<MulInstruction const*>(instruction) || dynamic_cast<DivInstruction const*>(instruction)
+		|| dynamic_cast<ModInstruction const*>(instruction) || dynamic_cast<CastInstruction const*>(instruction);
+}
+
+// dearer than the move that would replace them
+static bool expensive(Instruction const* instruction) {
+	return dynamic_cast<DereferenceInstruction const*>(instruction) || dynamic_cast<MulInstruction const*>(instruction)
+		|| dynamic_cast<DivInstruction const*>(instruction) || dynamic_cast<ModInstruction const*>(instruction);
+}
+
+static bool commutative(Instruction const* instruction) {
+	return dynamic_cast<AddInstruction const*>(instruction) || dynamic_cast<MulInstruction const*>(instruction)
+		|| dynamic_cast<BitwiseInstruction const*>(instruction);
+}
+
+// only ever read and written by name, so no store or call can change it
+static bool by_name_only(FunctionFacts const& facts, std::string name) {
+	return facts.stack->count(name) && !facts.address_taken.count(name);
+}
+
+// the operation and its operands without the destination, and the type of the result
+static bool value_key(Instruction const* instruction, FunctionStack const& stack, std::string& key) {
+	std::string d = instruction->get_destination();
+	if(d == "" || !stack.count(d) || stack.at(d).is_struct() || !reusable(instruction)) return false;
+	std::vector<std::string> sources = instruction->get_sources();
+	if(std::find(sources.begin(), sources.end(), d) != sources.end()) return false;
+
+	std::map<std::string, std::string> names;
+	names[d] = "";
+	// "a + b" and "b + a" are the same value when a and b have the same type
+	if(commutative(instruction) && sources.size() == 2 && sources.at(1) < sources.at(0)
+		&& stack.count(sources.at(0)) && stack.count(sources.at(1)) && stack.at(sources.at(0)).equals(stack.at(sources.at(1)))) {
+		names[sources.at(0)] = sources.at(1);
+		names[sources.at(1)] = sources.at(0);
+	}
+	Instruction* copy = instruction->clone();
+	copy->rename(names);
+	std::stringstream ss;
+	copy->Debug(ss);
+	delete copy;
+	key = ss.str() + stack.at(d).name();
+	return true;
+}
+
+// *******************************************
+
+static void forget_variable(ValueTable& table, std::string name) {
+	for(ValueTable::iterator itr = table.begin(); itr != table.end(); ) {
+		std::vector<std::string> const& sources = itr->second.sources;
+		if(itr->second.holder == name || std::find(sources.begin(), sources.end(), name) != sources.end()) {
+			table.erase(itr++);
+		} else {
+			++itr;
+		}
+	}
+}
+
+// loads the store may overwrite, and values read by name from memory it may reach
+static void forget_stored(ValueTable& table, FunctionFacts const& facts, MemoryRange const& store) {
+	for(ValueTable::iterator itr = table.begin(); itr != table.end(); ) {
+		Available const& value = itr->second;
+		bool changed = value.load && may_alias(*facts.stack, facts.escaped, store, value.range);
+		for(std::vector<std::string>::const_iterator s = value.sources.begin(); s != value.sources.end(); ++s) {
+			if(by_name_only(facts, *s)) continue;
+			if(store.direct ? store.base == *s : pointer_reachable(*facts.stack, facts.escaped, *s)) changed = true;
+		}
+		if(changed) {
+			table.erase(itr++);
+		} else {
+			++itr;
+		}
+	}
+}
+
+// anything the callee can reach through a pointer
+static void forget_reachable(ValueTable& table, FunctionFacts const& facts) {
+	for(ValueTable::iterator itr = table.begin(); itr != table.end(); ) {
+		Available const& value = itr->second;
+		bool changed = value.load && (!value.range.direct || pointer_reachable(*facts.stack, facts.escaped, value.range.base));
+		for(std::vector<std::string>::const_iterator s = value.sources.begin(); s != value.sources.end(); ++s) {
+			if(!by_name_only(facts, *s) && pointer_reachable(*facts.stack, facts.escaped, *s)) changed = true;
+		}
+		if(changed) {
+			table.erase(itr++);
+		} else {
+			++itr;
+		}
+	}
+}
+
+// the memory an instruction writes, whether through a pointer or by naming a variable
+// that lives in memory
+static bool stored_range(Instruction const* instruction, FunctionFacts const& facts, MemoryRange& range) {
+	if(dynamic_cast<AssignInstruction const*>(instruction)) return memory_access(instruction, *facts.stack, range);
+	std::string d = instruction->get_destination();
+	if(d == "" || by_name_only(facts, d)) return false;
+	MemoryRange whole = { d, 0, facts.stack->count(d) ? facts.stack->at(d).bytes() : 0, true };
+	range = whole;
+	return true;
+}
+
+// operands written once, before the value is worked out, and memory nothing in the
+// function writes: the value is the same wherever the block computing it dominates
+static bool lasting(FunctionFacts const& facts, unsigned block, std::set<std::string> const& written, Available const& value) {
+	if(!facts.definitions.count(value.holder) || facts.definitions.at(value.holder) != 1) return false;
+	for(std::vector<std::string>::const_iterator s = value.sources.begin(); s != value.sources.end(); ++s) {
+		if(!by_name_only(facts, *s)) return false;
+		if(!facts.definitions.count(*s)) continue;
+		if(facts.definitions.at(*s) != 1) return false;
+		if(written.count(*s)) continue;
+		unsigned b = facts.defining_block.at(*s);
+		if(b == block || !facts.cfg->dominates(b, block)) return false;
+	}
+	if(value.load) {
+		if(facts.calls && (!value.range.direct || pointer_reachable(*facts.stack, facts.escaped, value.range.base))) return false;
+		for(std::vector<MemoryRange>::const_iterator itr = facts.stores.begin(); itr != facts.stores.end(); ++itr) {
+			if(may_alias(*facts.stack, facts.escaped, *itr, value.range)) return false;
+		}
+	}
+	return true;
+}
+
+// whether later reads of the variable can be pointed at the earlier result: it is
+// written once, only read later in this block, and the earlier result stays put
+static bool forwardable(FunctionFacts const& facts, Liveness const& liveness, IRVector const& instructions,
+	unsigned block, unsigned position, std::string variable, std::string holder) {
+	if(!by_name_only(facts, variable) || facts.definitions.at(variable) != 1) return false;
+	if(liveness.live_in.at(block).count(variable) || liveness.live_out.at(block).count(variable)) return false;
+	for(unsigned i = position + 1; i < instructions.size(); i++) {
+		if(instructions.at(i)->get_destination() == holder) return false;
+	}
+	return true;
+}
+
+// *******************************************
+
+static bool number_block(FunctionFacts const& facts, Liveness const& liveness, std::vector<BasicBlock>& blocks,
+	std::vector<std::vector<unsigned> > const& children, unsigned block, ValueTable table) {
+	IRVector& instructions = blocks.at(block).instructions;
+	std::set<std::string> written;
+	bool changed = false;
+	for(unsigned i = 0; i < instructions.size(); i++) {
+		Instruction* instruction = instructions.at(i);
+		std::string d = instruction->get_destination();
+		std::string key;
+		bool keyed = value_key(instruction, *facts.stack, key);
+		std::string holder;
+		if(keyed && table.count(key)) {
+			holder = table.at(key).holder;
+		} else if(MoveInstruction* move = dynamic_cast<MoveInstruction*>(instruction)) {
+			// a copy is the same value under another name
+			std::string source = move->get_sources().at(0);
+			if(source != d && by_name_only(facts, source) && facts.stack->count(d)
+				&& !facts.stack->at(d).is_struct() && facts.stack->at(d).equals(facts.stack->at(source))) {
+				holder = source;
+			}
+		}
+		if(holder != "") {
+			if(forwardable(facts, liveness, instructions, block, i, d, holder)) {
+				// the rest of the block reads the earlier result and the instruction goes
+				std::map<std::string, std::string> names;
+				names[d] = holder;
+				for(unsigned j = i + 1; j < instructions.size(); j++) {
+					instructions.at(j)->rename(names);
+				}
+				delete instruction;
+				instructions.erase(instructions.begin() + i);
+				i--;
+				changed = true;
+				continue;
+			}
+			if(keyed && expensive(instruction)) {
+				instructions.at(i) = new MoveInstruction(d, holder);
+				delete instruction;
+				instruction = instructions.at(i);
+				keyed = false;
+				changed = true;
+			}
+		}
+
+		if(d != "") forget_variable(table, d);
+		MemoryRange store;
+		if(stored_range(instruction, facts, store)) forget_stored(table, facts, store);
+		if(dynamic_cast<FunctionCallInstruction*>(instruction)) forget_reachable(table, facts);
+
+		if(keyed && !table.count(key) && by_name_only(facts, d)) {
+			Available value;
+			value.holder = d;
+			value.sources = instruction->get_sources();
+			value.load = memory_access(instruction, *facts.stack, value.range);
+			value.lasting = facts.global && lasting(facts, block, written, value);
+			table[key] = value;
+		}
+		if(d != "") written.insert(d);
+	}
+	if(!facts.global) return changed;
+
+	// only what holds the same value everywhere below carries on down the dominator tree
+	for(ValueTable::iterator itr = table.begin(); itr != table.end(); ) {
+		if(itr->second.lasting) {
+			++itr;
+		} else {
+			table.erase(itr++);
+		}
+	}
+	std::vector<unsigned> const& below = children.at(block);
+	for(std::vector<unsigned>::const_iterator c = below.begin(); c != below.end(); ++c) {
+		if(number_block(facts, liveness, blocks, children, *c, table)) changed = true;
+	}
+	return changed;
+}
+
+static void number_values(IRVector& code, FunctionStack const& stack, bool global) {
+	ControlFlowGraph cfg(code);
+	Liveness liveness(cfg, stack);
+	FunctionFacts facts;
+	facts.stack = &stack;
+	facts.cfg = &cfg;
+	facts.address_taken = address_taken_variables(code);
+	facts.escaped = escaped_variables(code);
+	facts.calls = false;
+	facts.global = global;
+	for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+		IRVector const& instructions = cfg.blocks.at(b).instructions;
+		for(IRVector::const_iterator itr = instructions.begin(); itr != instructions.end(); ++itr) {
+			std::string d = (*itr)->get_destination();
+			if(d != "") {
+				facts.definitions[d]++;
+				facts.defining_block[d] = b;
+			}
+			MemoryRange store;
+			if(stored_range(*itr, facts, store)) facts.stores.push_back(store);
+			if(dynamic_cast<FunctionCallInstruction*>(*itr)) facts.calls = true;
+		}
+	}
+
+	std::vector<std::vector<unsigned> > children(cfg.blocks.size());
+	if(global) {
+		for(unsigned b = 1; b < cfg.blocks.size(); b++) {
+			if(cfg.is_reachable(b)) children.at(cfg.immediate_dominator(b)).push_back(b);
+		}
+		number_block(facts, liveness, cfg.blocks, children, 0, ValueTable());
+	} else {
+		for(unsigned b = 0; b < cfg.blocks.size(); b++) {
+			number_block(facts, liveness, cfg.blocks, children, b, ValueTable());
+		}
+	}
+	code = cfg.flatten();
+}
+
+void number_values_locally(IRVector& code, FunctionStack& stack) {
+	number_values(code, stack, false);
+}
+
+void number_values_globally(IRVector& code, FunctionStack& stack) {
+	number_values(code, stack, true);
+}
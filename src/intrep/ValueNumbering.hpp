@@ -0,0 +1,17 @@
+#ifndef IR_VALUE_NUMBERING_H
+#define IR_VALUE_NUMBERING_H
+
+#include "Instruction.hpp"
+#include "VariableMap.hpp"
+
+/*
+ * Common subexpressions: an operation or load that repeats one computed earlier in
+ * the same block, with no write to its operands and no store or call that may
+ * reach its memory in between, reads the earlier result instead of working it out
+ * again.  The global form also carries results down the dominator tree when the
+ * operands are only ever written once, so they hold the same value there.
+ */
+void number_values_locally(IRVector& code, FunctionStack& stack);
+void number_values_globally(IRVector& code, FunctionStack& stack);
+
+#endif
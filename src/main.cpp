@@ -21,6 +21,7 @@
 #define MODE_PARSE 3
 #define MODE_AST 4
 #define MODE_IR 5
+#define MODE_CFG 6
 
 /* lexer functions */
 void print_tokens();
@@ -38,6 +39,7 @@ void print_help();
 void debug_ast();
 void print_xml_ast();
 void generate_ir();
+void generate_cfg();
 void generate_mips();
 
 /* Will be written to by yyparse */
@@ -48,6 +50,7 @@ int main(int argc, char const *argv[]) {
 	int mode = MODE_COMPILE;
 	std::string infile;
 	std::string outfile;
+	bool peephole_stats = false;
 	yydebug = 0;
 
 	// determine mode of operation
@@ -74,6 +77,7 @@ int main(int argc, char const *argv[]) {
 
 		} else if(strcmp(argv[i], "--debug") == 0 || strcmp(argv[i], "-d") == 0) {
 			yydebug = 1;
+			pass_options().debug = true;
 
 		} else if(strcmp(argv[i], "--lex") == 0) {
 			mode = MODE_LEX;
@@ -87,6 +91,32 @@ int main(int argc, char const *argv[]) {
 			mode = MODE_COMPILE;
 		} else if(strcmp(argv[i], "--ir") == 0 || strcmp(argv[i], "-i") == 0) {
 			mode = MODE_IR;
+		} else if(strcmp(argv[i], "--cfg") == 0) {
+			mode = MODE_CFG;
+		} else if(strcmp(argv[i], "--peephole-stats") == 0) {
+			peephole_stats = true;
+		} else if(strcmp(argv[i], "-O0") == 0) {
+			pass_options().level = 0;
+		} else if(strcmp(argv[i], "-O1") == 0 || strcmp(argv[i], "-O") == 0) {
+			pass_options().level = 1;
+		} else if(strcmp(argv[i], "-O2") == 0) {
+			pass_options().level = 2;
+		} else if(strncmp(argv[i], "--print-after=", 14) == 0) {
+			pass_options().print_after = argv[i] + 14;
+			if(!pass_manager().has_pass(pass_options().print_after)) {
+				std::cerr << "Invalid: unknown pass " << pass_options().print_after << std::endl;
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--time-passes") == 0) {
+			pass_options().time_passes = true;
+		} else if(strncmp(argv[i], "--inline-threshold=", 19) == 0) {
+			pass_options().inline_threshold = atoi(argv[i] + 19);
+		} else if(strncmp(argv[i], "--unroll=", 9) == 0) {
+			pass_options().unroll = atoi(argv[i] + 9);
+		} else if(strcmp(argv[i], "-mips1") == 0) {
+			target_isa() = TARGET_MIPS1;
+		} else if(strcmp(argv[i], "-mips32") == 0) {
+			target_isa() = TARGET_MIPS32;
 
 		} else if(strcmp(argv[i], "-o") == 0) {
 			if(i + 1 < argc) {
@@ -152,10 +182,23 @@ int main(int argc, char const *argv[]) {
 		case MODE_COMPILE:
 			yyparse();
 			generate_mips();
+			if(peephole_stats) {
+				print_peephole_statistics(std::cerr);
+			}
+			if(pass_options().time_passes) {
+				print_pass_timings(std::cerr);
+			}
 			break;
 		case MODE_IR:
 			yyparse();
 			generate_ir();
+			if(pass_options().time_passes) {
+				print_pass_timings(std::cerr);
+			}
+			break;
+		case MODE_CFG:
+			yyparse();
+			generate_cfg();
 			break;
 		default:
 			std::cerr << "Error: unknown mode of operation " << mode << std::endl;
@@ -191,8 +234,20 @@ void print_help() {
 	std::cout << "  --ast            Parse the input into AST, format as text\n\n";
 	std::cout << "  --parse, --xml   Parse the input into AST, format as XML\n\n";
 	std::cout << "  -i, --ir         Compile the C code into an interm. rep.\n\n";
+	std::cout << "  --cfg            Print the interm. rep. as basic blocks\n\n";
 	std::cout << "  -S, --compile    Compile the C code into MIPS assembly\n\n";
+	std::cout << "  --peephole-stats Report instructions removed by each peephole rule\n\n";
+	std::cout << "  -O0, -O1, -O2    Optimisation level (default -O1)\n\n";
+	std::cout << "  --print-after=<pass> Dump the function to stderr after <pass>\n\n";
+	std::cout << "  --time-passes    Report the time spent in each pass\n\n";
+	std::cout << "  --inline-threshold=<n> Inline callees of at most <n> IR instructions (default 16)\n\n";
+	std::cout << "  --unroll=<n>     Make at most <n> copies of a loop body at -O2, 1 disables (default 8)\n\n";
+	std::cout << "  -mips1           Schedule for MIPS I load and hi/lo delays (default)\n\n";
+	std::cout << "  -mips32          Schedule for MIPS32, only branch delay slots are filled\n\n";
 	std::cout << "\nIf none specified, defaults to --compile" << std::endl << std::endl;
+	std::cout << "Passes and the level that enables them:\n";
+	pass_manager().print_passes(std::cout);
+	std::cout << std::endl;
 }
 
 void debug_ast() {
@@ -215,6 +270,18 @@ void generate_ir() {
 
 }
 
+void generate_cfg() {
+	try {
+		std::stringstream ss;
+		dynamic_cast<ProgramRoot*>(ast_root)->CompileCFG(ss);
+		fprintf(yyout, "%s", ss.str().c_str());
+	} catch(compile_error& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "compilation terminated." << std::endl;
+	}
+
+}
+
 void generate_mips() {
 	try {
 		std::stringstream ss;
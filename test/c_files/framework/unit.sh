@@ -2,10 +2,16 @@
 
 EXIT_CODE=0
 
+# optimisation level for lscc, e.g. -O2 (default: the compiler's own default)
+LEVEL=$3
+
+# extra lscc flags a test needs, from a "/*o ... */" line; they come after the level
+TEST_FLAGS=$(sed -n 's#^/\*o \(.*\) \*/$#\1#p' test/c_files/unit/$2.c)
+
 # compile the test program
 
 if [[ "$1" == "c_compiler" ]]; then
-	cat test/c_files/unit/$2.c | cpp | bin/c_compiler > test/out/asm/$2.s
+	cat test/c_files/unit/$2.c | cpp | bin/c_compiler $LEVEL $TEST_FLAGS > test/out/asm/$2.s
 	if [[ $? -ne 0 ]]; then
 		echo "Failed $2: program did not compile"
 		exit 1
@@ -18,7 +24,7 @@ if [[ "$1" == "c_compiler" ]]; then
 fi
 
 if [[ "$1" == "lscc" ]]; then
-	cat test/c_files/unit/$2.c | cpp | bin/lscc -S -o test/out/asm/$2.s
+	cat test/c_files/unit/$2.c | cpp | bin/lscc -S $LEVEL $TEST_FLAGS -o test/out/asm/$2.s
 	if [[ $? -ne 0 ]]; then
 		echo "Failed $2: program did not compile"
 		exit 1
@@ -31,7 +37,7 @@ if [[ "$1" == "lscc" ]]; then
 fi
 
 if [[ "$1" == "debug" ]]; then
-	cat test/c_files/unit/$2.c | cpp | bin/lscc -S -o test/out/asm/$2.s
+	cat test/c_files/unit/$2.c | cpp | bin/lscc -S $LEVEL $TEST_FLAGS -o test/out/asm/$2.s
 	mips-linux-gnu-gcc -std=c90 -static test/c_files/framework/unit_debugger.c test/out/asm/$2.s -o test/out/unit/$2
 	if [[ $? -ne 0 ]]; then
 		echo "Failed to compile $2"
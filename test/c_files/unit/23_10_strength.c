@@ -0,0 +1,41 @@
+/*d multiplication by constants and array indexing scaled without mult */
+/*@ 0 0 0 4015344 */
+/*@ 1 2 3 8502797 */
+/*@ -7 100 5 44618001 */
+/*@ 65537 -3 2 1010683351 */
+
+struct triple { int x; int y; int z; };
+
+char bytes[10];
+short halves[10];
+int words[10];
+double reals[10];
+struct triple triples[10];
+
+int products(int a, unsigned u) {
+    int r = a * 0 + a * 1 + a * -1 + a * 2 + a * 3 + a * 5 + a * 6 + a * 7;
+    r = r * 10 + a * 12 + 31 * a - a * 9 + a * 100;
+    r += a * 1000 + a * -16 + a * 255 + a * -1023;
+    r ^= (int)(u * 24 + u * 4096 + u * 65535);
+    return r;
+}
+
+int indexing(int a, int b) {
+    int i;
+    int sum = 0;
+    for(i = 0; i < 10; i++) {
+        bytes[i] = a + i;
+        halves[i] = b * i;
+        words[i] = a - i;
+        reals[i] = i;
+        triples[i].y = a + b + i;
+    }
+    for(i = 9; i >= 0; i--) {
+        sum = sum * 3 + bytes[i] + halves[i] + words[i] + (int)reals[i] + triples[i].y;
+    }
+    return sum;
+}
+
+int func(int a, int b, int c) {
+    return products(a, b) + products(c, a) * 3 + indexing(a, c) + indexing(b, a) * 7;
+}
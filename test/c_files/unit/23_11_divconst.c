@@ -0,0 +1,43 @@
+/*d division and modulo by constants without div */
+/*@ 0 0 0 0 */
+/*@ 12345 -678 9 1389026348 */
+/*@ -2147483647 2147483647 -1 1595093090 */
+/*@ 1000000007 -99999 65536 -519567960 */
+
+int digits(int n) {
+    int sum = 0;
+    if(n < 0) n = -n;
+    while(n != 0) {
+        sum = sum * 3 + n % 10;
+        n = n / 10;
+    }
+    return sum;
+}
+
+int quotients(int a) {
+    int r = a / 2 + a / 3 - a / 4 + a / 5 + a / 7 - a / -3 + a / 1000 + a / 641;
+    r ^= a % 2 + a % 3 + a % 8 + a % -7 + a % 1 + a / -1 + a % 65536 + a / 1024;
+    r += a / 2147483647 + a % 100000 + a / -8 + a % -16;
+    return r;
+}
+
+int unsigned_quotients(int a) {
+    unsigned u = a;
+    unsigned v = a;
+    unsigned w = a;
+    unsigned x = a;
+    unsigned y = a;
+    unsigned z = a;
+    u /= 10;
+    v %= 7;
+    w /= 641;
+    x %= 16;
+    y /= 4294967295u;
+    z /= 2147483649u;
+    return u + v * 3 + w * 5 + x * 7 + y * 11 + z * 13;
+}
+
+int func(int a, int b, int c) {
+    return quotients(a) + quotients(b) * 3 + quotients(c) * 5 + digits(a) + digits(b)
+        + unsigned_quotients(a) + unsigned_quotients(b) * 3 + unsigned_quotients(c) * 7;
+}
@@ -0,0 +1,53 @@
+/*d struct members and constant indices folded into load and store displacements */
+/*@ 0 0 0 203 */
+/*@ 1 2 3 1319 */
+/*@ -5 300 70000 9903101 */
+/*@ 127 -129 32768 2734919 */
+
+struct inner { char c; short s; int i; };
+struct outer { int tag; struct inner in; double d; struct inner first; struct inner second; };
+
+struct outer global;
+
+int sum_inner(struct inner* p) {
+    return p->c + p->s + p->i;
+}
+
+int through_pointer(struct outer* o, int a) {
+    int* q;
+    o->tag = a;
+    o->in.c = a;
+    o->in.s = a * 3;
+    o->in.i = a + 1;
+    o->d = a;
+    o->second.i = o->tag - 2;
+    o->first = o->in;
+    q = &o->second.i;
+    q = q - 1;
+    *(q + 1) += 5;
+    return o->tag + o->in.c + o->in.s + o->in.i + (int)o->d + o->second.i + sum_inner(&o->first);
+}
+
+int local_struct(int a, int b) {
+    struct outer l;
+    int arr[6];
+    int* mid = arr + 3;
+    l.tag = b;
+    l.in.i = a;
+    l.in.s = b;
+    l.in.c = a - b;
+    l.second = l.in;
+    arr[0] = a;
+    arr[5] = b;
+    mid[-1] = a + b;
+    mid[1] = a - b;
+    mid[0] = arr[0] + arr[5];
+    arr[1] = 7;
+    return l.tag * 3 + l.in.i + l.in.s + l.in.c + l.second.s + arr[1] + arr[2] + arr[3] + arr[4] + *(mid + 2);
+}
+
+int func(int a, int b, int c) {
+    int r = through_pointer(&global, a) + through_pointer(&global, c) * 3;
+    r += global.second.i + global.in.s;
+    return r * 7 + local_struct(a, b) + local_struct(c, a) * 5;
+}
@@ -0,0 +1,49 @@
+/*d arguments in registers across nested calls, narrow, float and struct parameters */
+/*@ 0 0 0 207 */
+/*@ 1 2 3 1844 */
+/*@ -7 40 100000 9297710 */
+/*@ 300 -2 5 92567 */
+
+struct pair { int x; int y; };
+
+int six(int a, int b, int c, int d, int e, int f) {
+    return a - b * 2 + c * 3 - d * 4 + e * 5 - f * 6;
+}
+
+int narrow(char c, short s, unsigned char u, int i) {
+    return c * 1000 + s * 10 + u + i;
+}
+
+float scale(float f, float g, int k) {
+    return f * g + k;
+}
+
+double mix(double d, int k, double e) {
+    return d * k - e;
+}
+
+struct pair make(int x, int y) {
+    struct pair p;
+    p.x = x + y;
+    p.y = x - y;
+    return p;
+}
+
+int take(struct pair p, int k) {
+    return p.x * k + p.y;
+}
+
+int chain(int a, int b, int c, int depth) {
+    int kept = a * 3 + b;
+    if(depth == 0) return kept + c;
+    return kept + chain(b, c, a + 1, depth - 1) * 2 - six(a, b, c, kept, depth, 1);
+}
+
+int func(int a, int b, int c) {
+    struct pair p = make(a, b);
+    int r = six(a, b, c, a + b, b + c, c + a);
+    r += narrow(a, b, c, r);
+    r += (int)scale(a, 2.0f, b) + (int)mix(c, a, 3.0);
+    r += take(p, c) + take(make(c, a), 3);
+    return r + chain(a, b, c, 4);
+}
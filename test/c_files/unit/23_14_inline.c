@@ -0,0 +1,77 @@
+/*d inlined helpers: tiny, inline hint, single call site, void, recursive, labels, floats */
+/*@ 0 0 0 -17 */
+/*@ 1 2 3 130 */
+/*@ -7 40 100000 399268 */
+/*@ 300 -2 5 1141 */
+
+int total;
+
+int max(int a, int b) {
+    if(a > b) return a;
+    return b;
+}
+
+static int clamp(int v, int lo, int hi) {
+    return max(lo, v < hi ? v : hi);
+}
+
+void add(int v) {
+    total += v;
+}
+
+inline int mix(int a, int b, int c) {
+    int i;
+    int r = 0;
+    for(i = 0; i < 4; i++) {
+        r = r * 3 + (a ^ i) - (b & c);
+        if(r > 100000) r = r % 977;
+    }
+    return r;
+}
+
+int once(int a, int b) {
+    int buf[4];
+    int i;
+    int s = 0;
+    for(i = 0; i < 4; i++) {
+        buf[i] = a * i + b;
+    }
+    for(i = 3; i >= 0; i--) {
+        s = s * 2 + buf[i] % 13;
+    }
+    return s;
+}
+
+int fact(int n) {
+    if(n <= 1) return 1;
+    return n * fact(n - 1);
+}
+
+int jump(int a) {
+    if(a < 0) goto negative;
+    return a + 1;
+negative:
+    return a - 1;
+}
+
+float half(int a) {
+    return a * 0.25f;
+}
+
+char narrow(int v) {
+    return v;
+}
+
+int func(int a, int b, int c) {
+    int r = max(a, b) + max(b, c) * 3;
+    int i;
+    total = 0;
+    for(i = 0; i < 5; i++) {
+        add(clamp(a + i * b, -50, 50));
+    }
+    r += total + mix(a, b, c) + mix(c, a, b);
+    r += once(a, c);
+    r += fact((a & 7) + 1) + jump(a) + jump(b);
+    r += (int)half(c * 4) + narrow(a + 200);
+    return r;
+}
@@ -0,0 +1,71 @@
+/*d tail calls: self recursion as loops, swapped and narrow parameters, calls that reuse the frame */
+/*@ 0 0 0 2339 */
+/*@ 1 2 3 2491 */
+/*@ -7 40 100000 401932 */
+/*@ 300 -2 5 4443 */
+
+int gcd(int a, int b) {
+    if(b == 0) return a;
+    return gcd(b, a % b);
+}
+
+int sum(int n, int acc) {
+    if(n <= 0) return acc;
+    return sum(n - 1, acc + n % 7);
+}
+
+int rotate(int a, int b, int c, int n) {
+    if(n == 0) return a * 100 + b * 10 + c;
+    return rotate(c, a, b, n - 1);
+}
+
+char wrap(char c, int n) {
+    if(n == 0) return c;
+    return wrap(c + 3, n - 1);
+}
+
+int count;
+
+void walk(int n) {
+    if(n <= 0) return;
+    count += n & 3;
+    walk(n - 2);
+}
+
+int collatz(int n, int steps) {
+    if(n <= 1) return steps;
+    if(n & 1) return collatz(3 * n + 1, steps + 1);
+    return collatz(n / 2, steps + 1);
+}
+
+int scaled(int x, int y, int k);
+
+int forward(int x, int y) {
+    int k = x * y + 3;
+    if(k > 50) return scaled(y, x, k);
+    return scaled(x, y, 2) - 1;
+}
+
+int scaled(int x, int y, int k) {
+    return gcd(x * k, y + k) + x - y;
+}
+
+float halve(float f, int n) {
+    if(n == 0) return f;
+    return halve(f * 0.5f, n - 1);
+}
+
+int func(int a, int b, int c) {
+    int r = gcd(a < 0 ? -a : a, b < 0 ? -b : b) + gcd(c, 96);
+    int i;
+    r += sum(600, 0) + rotate(a & 7, b & 7, c & 7, a & 15);
+    r += wrap(a, 50) + wrap(b, 2);
+    count = 0;
+    walk(400 + (c & 1));
+    r += count + collatz((a & 63) + 27, 0) * 3;
+    for(i = 0; i < 3; i++) {
+        r += forward(a + i, b - i);
+    }
+    r += (int)halve(c * 64, 4);
+    return r;
+}
@@ -0,0 +1,127 @@
+/*d loop invariants: member loads in conditions, globals, stores and calls that must keep loads in the loop */
+/*@ 0 0 0 45 */
+/*@ 1 2 3 704 */
+/*@ -7 40 10 9437 */
+/*@ 300 -2 5 246903 */
+
+struct vec {
+    int len;
+    int scale;
+    int *data;
+};
+
+int bias;
+int level;
+int table[8];
+
+void bump(int n) {
+    bias += n;
+}
+
+int total(struct vec *s, int k) {
+    int i;
+    int sum = 0;
+    for(i = 0; i < s->len; i++) {
+        sum += s->data[i] * (k + bias) + s->scale;
+    }
+    return sum;
+}
+
+/* the store through data may land on len or scale, so both are read every time */
+int rescale(struct vec *s, int *data) {
+    int i;
+    int sum = 0;
+    for(i = 0; i < s->len; i++) {
+        data[i] = data[i] * s->scale;
+        sum += data[i];
+    }
+    return sum;
+}
+
+/* writes to one member leave the other invariant */
+int shift(struct vec *s) {
+    int i;
+    for(i = 0; i < 6; i++) {
+        s->scale = s->scale + s->len;
+    }
+    return s->scale;
+}
+
+int grow(int n) {
+    int i;
+    int sum = 0;
+    for(i = 0; i < n; i++) {
+        sum += bias * 3;
+        bump(i & 1);
+    }
+    return sum;
+}
+
+int grid(int a, int b) {
+    int i;
+    int j;
+    int sum = 0;
+    for(i = 0; i < 5; i++) {
+        for(j = 0; j < 4; j++) {
+            sum += table[(i + j) & 7] * (a + b) + (a ^ b) * i;
+        }
+    }
+    return sum;
+}
+
+/* the loop writes what p points at by name, so *p is read every time */
+int through_local(int n) {
+    int x = n;
+    int s = 0;
+    int i = 0;
+    int *p = &x;
+    do {
+        s += *p;
+        x = x + 1;
+        i++;
+    } while(i < 3);
+    return s;
+}
+
+int through_global(int n) {
+    int s = 0;
+    int i = 0;
+    int *p = &level;
+    level = n;
+    do {
+        s += *p;
+        level = level + 1;
+        i++;
+    } while(i < 3);
+    return s;
+}
+
+int func(int a, int b, int c) {
+    struct vec v;
+    int values[6];
+    int i;
+    int r;
+    for(i = 0; i < 6; i++) {
+        values[i] = a * i + b;
+        table[i] = c - i;
+    }
+    table[6] = a;
+    table[7] = b;
+    bias = c & 15;
+    v.len = 6;
+    v.scale = (a & 3) + 1;
+    v.data = values;
+    r = total(&v, b);
+    r += rescale(&v, values) * 3;
+    r += shift(&v);
+    r += grow(5 + (a & 3));
+    r += grid(a, c) + bias;
+    i = 0;
+    while(i < v.len * 2) {
+        r += values[i % v.len] - i;
+        i++;
+    }
+    r += through_local(a) * 7;
+    r += through_global(b) * 11;
+    return r;
+}
@@ -0,0 +1,95 @@
+/*d induction variables: array walks by pointer, strides, steps down, limits that never let the loop run */
+/*@ 0 0 0 -13 */
+/*@ 1 2 3 26549 */
+/*@ -7 40 10 -144972 */
+/*@ 300 -2 5 3514858 */
+
+struct pt {
+    int x;
+    short y;
+    short tag;
+};
+
+int sum(int *a, int n) {
+    int i;
+    int s = 0;
+    for(i = 0; i < n; i++) {
+        s += a[i];
+    }
+    return s;
+}
+
+int sum_down(int *a, int n) {
+    int i;
+    int s = 0;
+    for(i = n - 1; i > 0; i--) {
+        s = s * 3 + a[i];
+    }
+    return s;
+}
+
+int evens(int *a, int n) {
+    int i;
+    int s = 0;
+    for(i = 0; i < n; i += 2) {
+        s += a[i] - a[i + 1];
+    }
+    return s;
+}
+
+int checksum(char *bytes, int n) {
+    int i;
+    int s = 0;
+    i = 0;
+    while(i < n) {
+        s = (s << 1) ^ bytes[i];
+        i++;
+    }
+    return s;
+}
+
+int points(struct pt *p, int n) {
+    int i;
+    int s = 0;
+    for(i = 0; i < n; i++) {
+        s += p[i].x * p[i].y + p[i].tag;
+    }
+    return s;
+}
+
+int last(int *a, int n) {
+    int i;
+    for(i = 0; i < n; i++) {
+        if(a[i] > 40) break;
+    }
+    return i;
+}
+
+int func(int a, int b, int c) {
+    int values[12];
+    int copy[12];
+    char text[8];
+    struct pt pts[5];
+    int i;
+    int r;
+    for(i = 0; i < 12; i++) {
+        values[i] = a * i - b + c * (i & 3);
+    }
+    for(i = 0; i < 12; i++) {
+        copy[i] = values[11 - i];
+    }
+    for(i = 0; i < 8; i++) {
+        text[i] = a + i * c;
+    }
+    for(i = 0; i < 5; i++) {
+        pts[i].x = a - i;
+        pts[i].y = b + i;
+        pts[i].tag = c;
+    }
+    r = sum(values, 12) + sum(copy, c & 7) + sum(values, b % 12);
+    r += sum_down(copy, 9) + sum_down(values, a % 12);
+    r += evens(values, 10) * 7 + checksum(text, 8) + checksum(text, c - 20);
+    r += points(pts, 5) + points(pts, a & 3);
+    r += last(values, 12) + i;
+    return r;
+}
@@ -0,0 +1,91 @@
+/*d unrolling at -O2: constant trip counts, remainders, steps down and by three, limits at the ends of int */
+/*o -O2 */
+/*@ 0 0 0 186 */
+/*@ 1 2 3 84183 */
+/*@ -7 40 10 -993391929 */
+/*@ 300 -2 5 -738189826 */
+
+int data[20];
+
+int checksum(char *bytes, int n) {
+    int i;
+    int s = 0;
+    for(i = 0; i < n; i++) {
+        s = (s << 1) + (s >> 7) + bytes[i];
+    }
+    return s;
+}
+
+void copy(int *dst, int *src, int n) {
+    int i;
+    for(i = 0; i < n; i++) {
+        dst[i] = src[i];
+    }
+}
+
+int fixed(int a) {
+    int i;
+    int s = 1;
+    for(i = 0; i < 4; i++) {
+        s = s * a + i;
+    }
+    for(i = 10; i < 10; i++) {
+        s++;
+    }
+    for(i = 0; i < 24; i += 3) {
+        s += data[i & 15] ^ i;
+    }
+    return s;
+}
+
+int down(int n) {
+    int i;
+    int s = 0;
+    for(i = n; i > 0; i--) {
+        s = s * 5 + data[i % 20] - i;
+    }
+    return s;
+}
+
+int stride(int from, int to) {
+    int i;
+    int s = 0;
+    for(i = from; i <= to; i += 3) {
+        s += i;
+    }
+    return s + i;
+}
+
+int edges(int a) {
+    int i;
+    int count = 0;
+    int low = -2147483647 - 1;
+    int high = 2147483647;
+    for(i = low; i < low + (a & 3); i++) {
+        count++;
+    }
+    for(i = high; i > high - (a & 5); i--) {
+        count += 2;
+    }
+    return count;
+}
+
+int func(int a, int b, int c) {
+    char text[13];
+    int other[20];
+    int i;
+    int r;
+    for(i = 0; i < 13; i++) {
+        text[i] = a * 7 + i * c;
+    }
+    for(i = 0; i < 20; i++) {
+        data[i] = a - i * b;
+    }
+    copy(other, data, 20 - (c & 7));
+    r = checksum(text, 13) + checksum(text, a & 15) + checksum(text, b % 12);
+    r += fixed(a) + fixed(c);
+    r += down(c & 15) + down(a) + other[c & 7];
+    r += stride(a, b) + stride(-c, c) * 3;
+    r += edges(a) + edges(c);
+    return r;
+}
@@ -0,0 +1,87 @@
+/*d common subexpressions: repeated member loads and products, stores and calls in between that must force a reload */
+/*o -O2 */
+/*@ 0 0 0 9 */
+/*@ 1 2 3 1130445 */
+/*@ -7 40 10 106099910 */
+/*@ 300 -2 5 1079236242 */
+
+struct point {
+    int x;
+    int y;
+};
+
+int counter;
+
+void tick(int n) {
+    counter += n;
+}
+
+int length2(struct point *p) {
+    return p->x * p->x + p->y * p->y;
+}
+
+/* q may point into p, so p->x is read again after the store */
+int overwrite(struct point *p, int *q, int v) {
+    int a = p->x + p->y;
+    *q = v;
+    return a * 10 + p->x + p->y;
+}
+
+/* the call may change counter */
+int around_call(int n) {
+    int a = counter * n;
+    tick(n);
+    return a + counter * n;
+}
+
+/* a local whose address is never taken keeps its value across the call */
+int local_across_call(int a, int b) {
+    int m = a * b;
+    int r;
+    tick(1);
+    r = a * b + m;
+    return r;
+}
+
+/* products worked out before the branch are reused inside it */
+int branches(int a, int b, int c) {
+    int m = a * b;
+    int r;
+    if(c > 4) {
+        r = a * b + c * a;
+    } else {
+        r = b * a - c * a;
+    }
+    return r + m + c * a;
+}
+
+/* writing a variable by name changes what its earlier uses computed */
+int renamed(int a, int b) {
+    int r = a * b;
+    a = a + 1;
+    return r + a * b;
+}
+
+int func(int a, int b, int c) {
+    struct point p;
+    int n;
+    int result;
+    p.x = a;
+    p.y = b;
+
+    result = length2(&p);
+    result = result * 3 + overwrite(&p, &p.x, c);
+    result = result * 3 + p.x;
+    result = result * 3 + overwrite(&p, &n, c);
+    result = result * 3 + n;
+
+    counter = a;
+    result = result * 3 + around_call(c);
+    result = result * 3 + counter;
+    result = result * 3 + local_across_call(a, b);
+    result = result * 3 + counter;
+
+    result = result * 3 + branches(a, b, c);
+    result = result * 3 + renamed(a, b);
+    return result;
+}
@@ -0,0 +1,22 @@
+/*d register pressure: more live values than registers across a loop and a call */
+/*@ 0 0 0 16 */
+/*@ 1 2 3 88 */
+/*@ 3 -1 0 40 */
+/*@ 10 5 2 220 */
+
+int twice(int x) {
+    return x + x;
+}
+
+int func(int a, int b, int c) {
+    int v0 = a, v1 = b, v2 = c, v3 = a + 1, v4 = b + 1;
+    int v5 = c + 1, v6 = a + b, v7 = b + c, v8 = a + c, v9 = 1;
+    int i, s = 0;
+    for(i = 0; i < 3; i++) {
+        s += v0 + v1 + v2 + v3 + v4;
+        s += twice(v5) - v5;
+        s += v6 + v7 + v8 + v9;
+        v9 = v9 + i;
+    }
+    return s + i;
+}
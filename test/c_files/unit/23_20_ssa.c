@@ -0,0 +1,132 @@
+/*d SSA form: locals written on several paths, values swapped around a loop, copies live after it */
+/*o -O2 */
+/*@ 0 0 0 -14917 */
+/*@ 1 2 3 935791 */
+/*@ -7 40 10 -889572 */
+/*@ 300 -2 5 -33930 */
+
+/* a and b trade places every iteration */
+int fib(int n) {
+    int a = 0;
+    int b = 1;
+    int t;
+    int i;
+    for(i = 0; i < n; i++) {
+        t = a + b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* x and y swap without a temporary of their own */
+int swaps(int x, int y, int n) {
+    int i;
+    int old;
+    for(i = 0; i < n; i++) {
+        old = x;
+        x = y;
+        y = old;
+    }
+    return x * 1000 + y;
+}
+
+/* the value before the last update is still needed after the loop */
+int previous(int n) {
+    int last = 0;
+    int before = -1;
+    while(last < n) {
+        before = last;
+        last = last * 2 + 1;
+    }
+    return before * 100 + last;
+}
+
+int pick(int a, int b, int c) {
+    int r;
+    if(a > b) {
+        r = a - b;
+    } else if(a < b) {
+        r = b - a;
+    } else {
+        r = c;
+    }
+    switch(c & 3) {
+        case 0: r = r + 1; break;
+        case 1: r = r * 3; break;
+        case 2: break;
+        default: r = -r;
+    }
+    return r;
+}
+
+int nested(int n) {
+    int i;
+    int j;
+    int s = 0;
+    int k = 0;
+    for(i = 0; i < n; i++) {
+        for(j = i; j < n && j != 5; j++) {
+            if(j & 1) {
+                s += i * j;
+                k = j;
+            }
+        }
+        s += k;
+    }
+    return s;
+}
+
+int func(int a, int b, int c) {
+    int result;
+    int i;
+    int f0 = 0;
+    int f1 = 1;
+    int t;
+    int n = c < 0 ? -c : c;
+    int last;
+    int before;
+    int r;
+    int s;
+    int k;
+    int j;
+
+    for(i = 0; i < n % 20; i++) {
+        t = f0 + f1;
+        f0 = f1;
+        f1 = t;
+    }
+    result = fib(n % 20) * 3 + f0;
+
+    result = result * 7 + swaps(a, b, n);
+
+    last = 0;
+    before = -1;
+    while(last < n * 7) {
+        before = last;
+        last = last * 2 + 1;
+    }
+    result = result * 7 + previous(n * 7) * 3 + before * 5 + last;
+
+    r = a > b ? a - b : (a < b ? b - a : c);
+    if((c & 3) == 0) r = r + 1;
+    else if((c & 3) == 1) r = r * 3;
+    else if((c & 3) == 3) r = -r;
+    result = result * 7 + pick(a, b, c) * 3 + r;
+
+    s = 0;
+    k = 0;
+    for(i = 0; i < n; i++) {
+        j = i;
+        while(j < n && j != 5) {
+            if(j & 1) {
+                s += i * j;
+                k = j;
+            }
+            j++;
+        }
+        s += k;
+    }
+    result = result * 7 + nested(n) * 3 + s + k;
+    return result;
+}
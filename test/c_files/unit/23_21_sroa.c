@@ -0,0 +1,95 @@
+/*d small local structs split into member variables: passed and returned by value, copied, narrow members, an escaping address */
+/*@ 0 0 0 -1597 */
+/*@ 1 2 3 126318 */
+/*@ -7 40 10 -625968 */
+/*@ 300 -2 5 6279024 */
+
+struct vec {
+    int x;
+    int y;
+};
+
+struct rgb {
+    char r;
+    unsigned char g;
+    short b;
+};
+
+struct vec saved;
+
+struct vec vadd(struct vec a, struct vec b) {
+    struct vec r;
+    r.x = a.x + b.x;
+    r.y = a.y + b.y;
+    return r;
+}
+
+int vdot(struct vec a, struct vec b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+/* recursive, so the struct really goes through memory between calls */
+struct vec walk(struct vec v, int n) {
+    if(n <= 0) {
+        return v;
+    }
+    v.x = v.x * 2;
+    v.y = v.y + 1;
+    return walk(v, n - 1);
+}
+
+void nudge(struct vec *p) {
+    p->x = p->x + 1;
+}
+
+int pack(struct rgb c) {
+    return c.r * 100000 + c.g * 1000 + c.b;
+}
+
+int func(int a, int b, int c) {
+    struct vec p;
+    struct vec q;
+    struct vec t;
+    struct vec w;
+    struct vec e;
+    struct rgb col;
+    int n = c < 0 ? -c : c;
+    int i;
+    int result;
+
+    p.x = a;
+    p.y = b;
+    q.x = c;
+    q.y = a;
+    t = vadd(p, q);
+    result = t.x * 3 + t.y * 5 + vdot(p, q);
+
+    /* whole struct copies back and forth in a loop */
+    for(i = 0; i < n; i++) {
+        t = p;
+        p = q;
+        q = t;
+        p.x = p.x + i;
+    }
+    result = result * 7 + p.x * 11 + p.y * 13 + q.x * 17 + q.y * 19;
+
+    /* a struct that lives in memory on the other side of the copies */
+    saved = p;
+    w = saved;
+    w.y = w.y - 3;
+    result = result * 3 + w.x * 23 + w.y * 29;
+
+    w = walk(w, n % 5);
+    result = result * 5 + w.x * 31 + w.y * 37;
+
+    /* only some members written before the call, the rest still counts */
+    e.x = b;
+    e.y = c;
+    nudge(&e);
+    result = result * 3 + e.x * 41 + e.y * 43;
+
+    col.r = a;
+    col.g = b;
+    col.b = c * 1000;
+    return result + pack(col);
+}
@@ -0,0 +1,44 @@
+/*d peephole rules: a store followed by a load of the same slot, chains of copies, jumps to the label straight after them */
+/*@ 0 0 0 0 */
+/*@ 1 2 3 47 */
+/*@ -7 40 10 19 */
+/*@ 300 -2 5 9886 */
+
+/* the element is written to its slot and read straight back from it */
+int store_load(int a, int b) {
+    int slots[4];
+    slots[1] = a;
+    slots[2] = b;
+    slots[3] = slots[1] * 3 + slots[2];
+    return slots[3];
+}
+
+/* each local is only a copy of the one before it */
+int copies(int a, int b) {
+    int x = a;
+    int y = x;
+    int z = y;
+    int w = b;
+    return z - w + y;
+}
+
+/* the branch of an if without an else ends in a jump to the label straight after it */
+int fall_through(int a, int b) {
+    int r = a;
+    if(a > b) {
+        r = b;
+    } else {
+    }
+    while(r > 100) {
+        r = r - 100;
+    }
+    return r;
+}
+
+int func(int a, int b, int c) {
+    int result;
+    result = store_load(a, b);
+    result = result * 3 + copies(a, b);
+    result = result * 3 + fall_through(b, c);
+    return result;
+}
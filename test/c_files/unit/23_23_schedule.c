@@ -0,0 +1,68 @@
+/*d instruction scheduling: loads used straight away and next to branches, delay slots to fill, hi and lo read just before the next multiply or divide */
+/*@ 0 0 0 490000684 */
+/*@ 1 2 3 169055799 */
+/*@ -7 40 10 34680484 */
+/*@ 300 -2 5 382446916 */
+
+int table[8];
+
+/* every loaded element is compared by the branch right after the load */
+int count_above(int n, int limit) {
+    int i;
+    int count = 0;
+    for(i = 0; i < n; i++) {
+        if(table[i] > limit) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* each load feeds the next instruction */
+int chain(int a) {
+    int x;
+    table[0] = a;
+    table[1] = table[0] + 1;
+    table[2] = table[1] * 2;
+    x = table[2] - table[0];
+    return x;
+}
+
+/* the quotient is read and the next division starts straight after it */
+int divisions(int a, int b, int c) {
+    int q = a / b;
+    int r = q % c;
+    int m = r * q;
+    return q * 10000 + r * 100 + m / c;
+}
+
+/* products read back between multiplies */
+int products(int a, int b, int c) {
+    int x = a * b;
+    int y = x * c;
+    int z = y * x;
+    return x + y - z;
+}
+
+/* a call whose argument is worked out just before it */
+int twice(int a) {
+    return a + a;
+}
+
+int calls(int a, int b) {
+    return twice(a * 3) - twice(table[1] + b);
+}
+
+int func(int a, int b, int c) {
+    int i;
+    int result;
+    for(i = 0; i < 8; i++) {
+        table[i] = a * i - b;
+    }
+    result = count_above(8, c);
+    result = result * 7 + chain(a);
+    result = result * 7 + divisions(a * 37 + 1000, (b & 15) + 1, (c & 7) + 2);
+    result = result * 7 + products(a, b, c);
+    result = result * 7 + calls(a, c);
+    return result;
+}
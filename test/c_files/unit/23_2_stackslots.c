@@ -0,0 +1,14 @@
+/*d stack slot sharing: many short-lived double temporaries */
+/*@ 0 0 0 0 */
+/*@ 1 2 3 26 */
+/*@ 4 -2 1 0 */
+/*@ 10 10 10 85 */
+
+int func(int a, int b, int c) {
+    double x = a, y = b, z = c;
+    double s = x * 2.0 + y * 3.0;
+    s = s + (z - x) * 4.0 - (y + z) * 0.5;
+    s = s + (x + y + z) * 1.5;
+    s = s - (x * y - z * z) / 2.0;
+    return s;
+}
@@ -0,0 +1,28 @@
+/*d constant folding: C89 conversions of folded constants and constant loop conditions */
+/*@ 0 0 0 0 */
+/*@ 1 2 3 0 */
+
+int func(int a, int b, int c) {
+    char ch = 300;
+    unsigned char uc = -1;
+    unsigned u = -8;
+    int s = -8;
+    int r = 0;
+    int n = 0;
+
+    r = r + ch;              /* 44 */
+    r = r + uc;              /* 255 */
+    r = r + (s / 2) + (s % 3) + (s >> 1);   /* -4 - 2 - 4 */
+    r = r + (u >> 29);       /* 7 */
+    r = r + (s < 1) + (u < 1);
+    r = r + (3 > 2 && 0 || !0) * 10;
+    while(1) {
+        n = n + 1;
+        if(n == 5) break;
+    }
+    r = r + n * 100;
+    if(r == 807) {
+        return a - a;
+    }
+    return r;
+}
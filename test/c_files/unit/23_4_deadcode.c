@@ -0,0 +1,30 @@
+/*d dead code: discarded call results, unused locals and code after return */
+/*@ 0 0 0 3 */
+/*@ 1 2 3 9 */
+/*@ 5 -1 2 9 */
+
+int counter;
+
+int bump(int n) {
+    counter = counter + n;
+    return counter;
+}
+
+int func(int a, int b, int c) {
+    int unused = a * b;
+    int arr[8];
+    counter = 0;
+    bump(a);
+    bump(b + c);
+    unused = bump(3);
+    if(counter > 5) {
+        return counter;
+        counter = 100;
+    } else {
+        goto out;
+        counter = 200;
+    }
+    counter = 300;
+out:
+    return counter;
+}
@@ -0,0 +1,48 @@
+/*d switch dispatch: dense cases through a jump table, sparse and negative ones by binary search */
+/*@ 0 0 0 -9994 */
+/*@ 1 100 -3 110536 */
+/*@ 3 -1000 7 130202 */
+/*@ 6 65536 -100000 160616 */
+/*@ 9 5 -7 -9595 */
+
+int dense(int x) {
+    switch(x) {
+        case 1: return 11;
+        case 2: return 12;
+        case 3: return 13;
+        case 4: return 34;
+        case 6: return 16;
+        case 7: x = x * 2;
+        case 8: return x + 100;
+    }
+    return -1;
+}
+
+int sparse(int x) {
+    switch(x) {
+        case -100000: return 1;
+        case -1000: return 2;
+        case -3: return 3;
+        case 5: return 4;
+        case 100: return 5;
+        case 65536: return 6;
+        default: return 0;
+    }
+}
+
+int unsigned_sparse(unsigned x) {
+    int r = 0;
+    switch(x) {
+        case 2: r = 1; break;
+        case 7: r = 2; break;
+        case 300: r = 3; break;
+        case 0x80000000: r = 4; break;
+        case 0xfffffff9: r = 5; break;
+        default: r = 6;
+    }
+    return r;
+}
+
+int func(int a, int b, int c) {
+    return dense(a) * 10000 + sparse(b) * 100 + sparse(c) * 10 + unsigned_sparse(c);
+}
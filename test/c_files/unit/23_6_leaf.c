@@ -0,0 +1,31 @@
+/*d leaf functions: accessors without a frame, unused and address-taken parameters */
+/*@ 0 0 0 0 */
+/*@ 1 2 3 203412 */
+/*@ 7 -3 12 -2233773 */
+
+struct pair { int first; int second; };
+
+int second(struct pair* p) { return p->second; }
+
+int swap_sub(int a, int b, int unused, int d) { return d - a * b; }
+
+int by_address(int a, int b) {
+    int* p = &b;
+    *p = *p + a;
+    return b;
+}
+
+int narrow(char c, int x) { return c + x; }
+
+int many(int a, int b, int c, int d) {
+    int t0 = a + b, t1 = b + c, t2 = c + d, t3 = d + a, t4 = a * c, t5 = b * d;
+    return t0 * t1 - t2 * t3 + t4 - t5;
+}
+
+int func(int a, int b, int c) {
+    struct pair q;
+    q.first = a;
+    q.second = b;
+    return second(&q) + swap_sub(a, b, c, c) * 10 + by_address(a, c) * 100
+        + narrow(a, b) * 1000 + many(a, b, c, a - b) * 10000;
+}
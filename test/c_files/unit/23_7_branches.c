@@ -0,0 +1,53 @@
+/*d fused compare-and-branch in if, loops and ternaries, signed, unsigned, pointers and floats */
+/*@ 0 0 0 201021000 */
+/*@ 3 -2 5 301315123 */
+/*@ -7 7 -1 300930000 */
+/*@ 10 10 2 306021011 */
+
+int count(int lo, int hi) {
+    int i, n = 0;
+    for(i = lo; i <= hi; i++) {
+        if(i > 0) n += 1;
+        if(i >= 2) n += 10;
+        if(i < -1) n += 100;
+        if(i != 3) n += 1000;
+    }
+    return n;
+}
+
+int unsigned_less(unsigned a, unsigned b) {
+    return a < b ? 1 : a == b ? 2 : 3;
+}
+
+int walk(int* p, int* end) {
+    int s = 0;
+    while(p < end) {
+        s += *p;
+        p++;
+    }
+    return s;
+}
+
+int countdown(int n) {
+    int steps = 0;
+    do {
+        steps++;
+        n -= 3;
+    } while(n > 0);
+    return steps;
+}
+
+int truth(float f, double d) {
+    int r = 0;
+    if(f) r += 1;
+    if(d) r += 2;
+    while(f) f = 0;
+    return r;
+}
+
+int func(int a, int b, int c) {
+    int arr[4];
+    arr[0] = a; arr[1] = b; arr[2] = c; arr[3] = 1;
+    return count(b, a) + unsigned_less(a, b) * 10000 + walk(arr, arr + c % 4 + (c < 0 ? 4 : 0)) * 100000
+        + countdown(a) * 1000000 + truth(a * 0.5f, c - 1) * 100000000;
+}
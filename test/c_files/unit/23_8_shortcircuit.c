@@ -0,0 +1,44 @@
+/*d short-circuit && || and ! in conditions and values */
+/*@ 0 0 0 53612 */
+/*@ 1 2 3 83303 */
+/*@ -4 0 9 80314 */
+/*@ 5 5 -5 82207 */
+
+struct node { int value; struct node* next; };
+
+int calls;
+struct node* nil;
+
+int seen(int x) {
+    calls++;
+    return x;
+}
+
+int length(struct node* p) {
+    int n = 0;
+    while(p && p->value >= 0) {
+        n++;
+        p = p->next;
+    }
+    return n;
+}
+
+int classify(int a, int b, int c) {
+    int r = 0;
+    if(seen(a) && seen(b)) r += 1;
+    if(seen(a) || seen(c)) r += 2;
+    if(!(seen(b) > 0 && seen(c) > 0)) r += 4;
+    if(!seen(a) || !seen(b) && seen(c)) r += 8;
+    return r;
+}
+
+int func(int a, int b, int c) {
+    struct node n1, n2, n3;
+    int v;
+    n1.value = a; n1.next = &n2;
+    n2.value = b; n2.next = &n3;
+    n3.value = c; n3.next = nil;
+    calls = 0;
+    v = (a < b && b < c) + (a == 0 || seen(c)) * 2 + !(a || b) * 4;
+    return classify(a, b, c) + v * 100 + length(&n1) * 1000 + calls * 10000;
+}
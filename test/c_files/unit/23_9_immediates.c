@@ -0,0 +1,54 @@
+/*d arithmetic, bitwise, shift and comparison operands that fit in an immediate */
+/*@ 0 0 0 1330798 */
+/*@ 1 2 3 806873 */
+/*@ 32767 -32768 65535 -45999 */
+/*@ -1 255 40000 1945136 */
+
+int table[8];
+
+int compare(int a, unsigned u) {
+    int r = 0;
+    if(a < 10) r |= 1;
+    if(a <= 32767) r |= 2;
+    if(a > -32768) r |= 4;
+    if(a >= -32768) r |= 8;
+    if(10 < a) r |= 16;
+    if(a == 255) r |= 32;
+    if(a != 65535) r |= 64;
+    if(u < 100) r |= 128;
+    if(u >= 65535) r |= 256;
+    if(u > 4294967295u) r |= 512;
+    r += (a < 0) * 1024 + (a == 32767) * 2048 + (a != -32768) * 4096;
+    r += (u <= 40000) * 8192 + (a > 2147483647) * 16384 + (a == 70000) * 32768;
+    return r;
+}
+
+int bits(int a, unsigned u) {
+    int flags = a & 0xff;
+    flags |= 4;
+    flags ^= 0xffff;
+    return flags + (a << 3) + (a >> 2) + (int)(u >> 31) + ((a - 1) & 65535) + ((u + 32767) ^ 3);
+}
+
+int pointers(int a) {
+    int* p = table;
+    int* q;
+    int i;
+    for(i = 0; i < 8; i++) {
+        *p = a + i * 3;
+        p = p + 1;
+    }
+    q = p - 2;
+    p = q - 5;
+    return *q * 10 + *p + *(table + 7) - *(p + 1);
+}
+
+int func(int a, int b, int c) {
+    unsigned u = c;
+    int sum = 0;
+    int i;
+    for(i = 0; i < 5; i++) {
+        sum += i + 100000;
+    }
+    return compare(a, u) + compare(b, b) * 3 + bits(a, u) * 7 + bits(c, b) + pointers(b) * 11 + sum - 32000 - 500010;
+}
@@ -36,22 +36,67 @@ mkdir -p test/out/asm
 rm -f test/out/asm/*
 rm -f test/out/unit/*
 
-# run test/c_files/framework/unit.sh for each file in c_files/unit/
+# run test/c_files/framework/unit.sh for each file in c_files/unit/, once for each
+# optimisation level when the tests are compiled with lscc
+
+if [[ "$cmd" == "gcc" ]]; then
+	LEVELS=("")
+else
+	LEVELS=("-O0" "-O1" "-O2")
+fi
 
 PASSED=0
 TOTAL=0
 
-for f in test/c_files/unit/*.c
+for level in "${LEVELS[@]}"
 do
-	b=$(basename $f)
-	testname=${b%.*}
-	test/c_files/framework/unit.sh $cmd $testname
-	if [[ "$?" -eq "0" ]]; then
+	for f in test/c_files/unit/*.c
+	do
+		b=$(basename $f)
+		testname=${b%.*}
+		test/c_files/framework/unit.sh $cmd $testname $level
+		if [[ "$?" -eq "0" ]]; then
+			((PASSED++))
+			echo "Passed all tuples for $testname $level"
+		fi
+		((TOTAL++))
+	done
+done
+
+# compiler options the unit tests cannot see
+
+if [[ "$cmd" == "lscc" ]]; then
+	OPTION_SOURCE="int f(int a, int b) { int c = a * b; return c + a; }"
+
+	((TOTAL++))
+	if echo "$OPTION_SOURCE" | bin/lscc -S --print-after=regalloc -o /dev/null 2>&1 | grep -q "# IR of f after regalloc"; then
 		((PASSED++))
-		echo "Passed all tuples for $testname"
+		echo "Passed --print-after prints the function"
+	else
+		echo "Failed --print-after: nothing printed for regalloc"
 	fi
+
 	((TOTAL++))
-done
+	if ! echo "$OPTION_SOURCE" | bin/lscc -S --print-after=no-such-pass -o /dev/null 2>&1 | grep -q "unknown pass"; then
+		echo "Failed --print-after: an unknown pass was accepted"
+	elif echo "$OPTION_SOURCE" | bin/lscc -S --print-after=no-such-pass -o /dev/null >/dev/null 2>&1; then
+		echo "Failed --print-after: an unknown pass did not fail"
+	else
+		((PASSED++))
+		echo "Passed --print-after rejects unknown passes"
+	fi
+
+	for rule in store-load copy-forward jump-to-next
+	do
+		((TOTAL++))
+		if cat test/c_files/unit/23_22_peephole.c | cpp | bin/lscc -S -O1 --peephole-stats -o /dev/null 2>&1 | grep -q "# peephole $rule: [1-9]"; then
+			((PASSED++))
+			echo "Passed --peephole-stats reports $rule"
+		else
+			echo "Failed --peephole-stats: $rule did not fire on 23_22_peephole"
+		fi
+	done
+fi
 
 # output summary
 